@@ -465,6 +465,28 @@ void EXPORT mc_inexactp( word *globals );
 void mul_32x32_to_64( word a, word b, word *hi, word *lo );
 void umul_32x32_to_64( word a, word b, word *hi, word *lo );
 
+/* HAVE_OVERFLOW_BUILTINS is 1 if the C compiler provides the type-generic
+   __builtin_add_overflow, __builtin_sub_overflow, and
+   __builtin_mul_overflow (gcc 5 and later, clang 3.8 and later).
+   */
+
+#if !defined HAVE_OVERFLOW_BUILTINS
+#  if defined __has_builtin
+#    if __has_builtin( __builtin_add_overflow ) && \
+        __has_builtin( __builtin_sub_overflow ) && \
+        __has_builtin( __builtin_mul_overflow )
+#      define HAVE_OVERFLOW_BUILTINS 1
+#    endif
+#  endif
+#endif
+#if !defined HAVE_OVERFLOW_BUILTINS
+#  if defined __GNUC__ && __GNUC__ >= 5 && !defined __clang__
+#    define HAVE_OVERFLOW_BUILTINS 1
+#  else
+#    define HAVE_OVERFLOW_BUILTINS 0
+#  endif
+#endif
+
 #endif /* MILLICODE_H */
 
 /* eof */
@@ -12,7 +12,7 @@
 
 /* Configuration happens through features.sch */
 
-/* Jump discipline.  Exactly one of these three should be true.  */
+/* Jump discipline.  Exactly one of these four should be true.  */
 
 /* #define USE_LONGJUMP               0 */
    /* Jump, invoke and return are implemented as calls; when the timer
@@ -33,6 +33,20 @@
      rather than being stored in a global.
      */
 
+/* #define USE_MUSTTAIL               0 */
+  /* Jump, invoke, and return are implemented as tail calls that the
+     compiler guarantees not to grow the C stack (musttail), so control
+     passes directly from one compiled procedure to the next.  Procedures
+     have the same type as with USE_RETURN_WITH_VALUE, and the dispatch
+     loop is entered only on exceptional paths: when an exception is
+     signalled, and after the outer loop has been reentered by longjmp.
+
+     Requires USE_GOTOS_LOCALLY and a compiler that implements
+     __attribute__((musttail)) (clang 13 and later, gcc 15 and later).
+     If the attribute is not available then USE_RETURN_WITH_VALUE is
+     selected instead.
+     */
+
 
 /* Additional control of control flow discipline.  Combine this with one
    of the preceding three.
@@ -69,9 +83,23 @@
      context the procedure in R0. 
      */
 
+#if defined __has_attribute
+#  if __has_attribute( musttail )
+#    define HAVE_MUSTTAIL 1
+#  endif
+#endif
+#if !defined HAVE_MUSTTAIL
+#  define HAVE_MUSTTAIL 0
+#endif
+#if defined USE_MUSTTAIL && \
+    (!HAVE_MUSTTAIL || (defined USE_GOTOS_LOCALLY && !USE_GOTOS_LOCALLY))
+#  undef USE_MUSTTAIL
+#endif
+
 #if !defined USE_LONGJUMP && \
     !defined USE_RETURN_WITHOUT_VALUE && \
-    !defined USE_RETURN_WITH_VALUE
+    !defined USE_RETURN_WITH_VALUE && \
+    !defined USE_MUSTTAIL
 #  define USE_RETURN_WITH_VALUE 1
 #endif
 #if !defined USE_LONGJUMP
@@ -83,6 +111,9 @@
 #if !defined USE_RETURN_WITH_VALUE
 #  define USE_RETURN_WITH_VALUE 0
 #endif
+#if !defined USE_MUSTTAIL
+#  define USE_MUSTTAIL 0
+#endif
 #if !defined USE_GOTOS_LOCALLY
 #  define USE_GOTOS_LOCALLY 1
 #endif
@@ -96,7 +127,7 @@
 #elif USE_RETURN_WITHOUT_VALUE
 # define RTYPE void
 # define RETURN_RTYPE( expr ) (void)(expr)
-#elif USE_RETURN_WITH_VALUE
+#elif USE_RETURN_WITH_VALUE || USE_MUSTTAIL
 # define RTYPE cont_t
 # define RETURN_RTYPE( expr ) return (expr)
 #else
@@ -128,6 +159,17 @@ typedef void (*cont_t)( CONT_PARAMS );
 #endif
 
 
+/* MUSTTAIL prefixes a return statement whose value is a call that must
+   be compiled as a tail call.
+   */
+
+#if USE_MUSTTAIL
+# define MUSTTAIL __attribute__((musttail))
+#else
+# define MUSTTAIL
+#endif
+
+
 /* Timer ticks */
 
 #if USE_LONGJUMP
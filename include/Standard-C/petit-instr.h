@@ -287,6 +287,36 @@ extern cont_t twobit_cont_label;
    WITH_SAVED_STATE( e ); \
    twobit_label( k_numeric, k_symbolic ) 
 
+/* Fixnum arithmetic with overflow detection.  Each of these stores the
+   tagged result of the operation on the tagged fixnums a and b in the
+   word variable res, and is nonzero if the result overflowed.  With the
+   compiler builtins the test compiles to the add/sub/imul followed by a
+   jump on the overflow flag, the same code as for plain C ints.
+
+   Without the builtins, + and - use the sign-bit tests below, and * 
+   succeeds only when both operands are small enough that the product 
+   cannot overflow; other cases go to millicode.
+   */
+#if HAVE_OVERFLOW_BUILTINS
+# define fixnum_add_overflow( a, b, res ) \
+   __builtin_add_overflow( (s_word)(a), (s_word)(b), (s_word*)&(res) )
+# define fixnum_sub_overflow( a, b, res ) \
+   __builtin_sub_overflow( (s_word)(a), (s_word)(b), (s_word*)&(res) )
+# define fixnum_mul_overflow( a, b, res ) \
+   __builtin_mul_overflow( (s_word)(a) >> 2, (s_word)(b), (s_word*)&(res) )
+#else
+# define fixnum_add_overflow( a, b, res ) \
+   ((res) = (a) + (b), \
+    (s_word)((a) ^ (b)) >= 0 && (s_word)((res) ^ (a)) < 0)
+# define fixnum_sub_overflow( a, b, res ) \
+   ((res) = (a) - (b), \
+    (s_word)((a) ^ (b)) < 0 && (s_word)((res) ^ (a)) < 0)
+# define fixnum_mul_overflow( a, b, res ) \
+   ((word)((s_word)(a) + 0x8000) >= 0x10000 || \
+    (word)((s_word)(b) + 0x8000) >= 0x10000 || \
+    ((res) = (word)(((s_word)(a) >> 2) * (s_word)(b)), 0))
+#endif
+
 /* From MIPS R4000 manual: Signed add with overflow detection.
 
    --- compute t0 = t1 + t2, branch to L on signed overflow
@@ -299,13 +329,10 @@ extern cont_t twobit_cont_label;
 1:
 */
 #define twobit_add( x, y, kn, k ) /* addition */ \
-   do { word a = x, b = y; \
-        if (is_both_fixnums( a, b )) { \
-          word res = a + b; \
-          if ((s_word)(a ^ b) < 0 || (s_word)(res ^ a) >= 0) { \
-            RESULT = res; \
-            twobit_skip(kn,k); \
-          } \
+   do { word a = x, b = y, res; \
+        if (is_both_fixnums( a, b ) && !fixnum_add_overflow( a, b, res )) { \
+          RESULT = res; \
+          twobit_skip(kn,k); \
         } \
         SECOND = b; \
    } while(0); \
@@ -323,18 +350,26 @@ extern cont_t twobit_cont_label;
 1:
 */
 #define twobit_subtract( x, y, kn, k ) /* subtraction */ \
-   do { word a = x, b = y; \
-	if (is_both_fixnums( a, b )) { \
-          word res = a - b; \
-          if ((s_word)(a ^ b) >= 0 || (s_word)(res ^ a) >= 0) { \
-            RESULT = res; \
-            twobit_skip(kn,k); \
-          } \
+   do { word a = x, b = y, res; \
+	if (is_both_fixnums( a, b ) && !fixnum_sub_overflow( a, b, res )) { \
+          RESULT = res; \
+          twobit_skip(kn,k); \
         } \
         SECOND = b; \
    } while(0); \
    implicit_label( mc_sub( globals, CONT_LOCAL(kn,k) ), kn, k )
 
+/* Multiplication; the fixnum case used to be left to millicode. */
+#define twobit_multiply( x, y, kn, k ) /* multiplication */ \
+   do { word a = x, b = y, res; \
+	if (is_both_fixnums( a, b ) && !fixnum_mul_overflow( a, b, res )) { \
+          RESULT = res; \
+          twobit_skip(kn,k); \
+        } \
+        SECOND = b; \
+   } while(0); \
+   implicit_label( mc_mul( globals, CONT_LOCAL(kn,k) ), kn, k )
+
 /* Comparison (=, <, <=, >, >=) */
 #define twobit_compare( x, y, op, generic, kn, k ) /* numeric comparison */ \
   do { word a = x, b = y; \
@@ -505,13 +540,18 @@ extern cont_t twobit_cont_label;
    twobit_skip( -1, DECODE_RETURN_ADDRESS(stack( STK_RETURN )) )
 #endif
 
-#if USE_GOTOS_LOCALLY
-# define twobit_invoke( n ) \
+#define twobit_invoke( n ) \
    do { word a=RESULT; \
         if (tagof(a) != PROC_TAG) { \
           FAIL( EX_NONPROC ); \
         } \
-        reg(0) = a; \
+        twobit_invoke_proc( a, n ); \
+   } while(0)
+
+/* Invoke p, which is known to be a procedure. */
+#if USE_GOTOS_LOCALLY
+# define twobit_invoke_proc( p, n ) \
+   do { reg(0) = p; \
         RESULT = fixnum(n); \
         if (!--TIMER) \
           WITH_SAVED_STATE( mc_timer_exception( globals, (cont_t)0 ) );	\
@@ -519,19 +559,42 @@ extern cont_t twobit_cont_label;
         nonlocal_control_transfer( reg(0), 0 ); \
    } while(0)
 #else 
-# define twobit_invoke( n ) \
-  do { cont_t invL; word a=RESULT; \
-       if (tagof(a) != PROC_TAG) { \
-         FAIL( EX_NONPROC ); \
-       } \
-       invL = (cont_t)*proc_addr( a, IDX_PROC_CODE ); \
-       reg(0) = a; \
+# define twobit_invoke_proc( p, n ) \
+  do { cont_t invL; \
+       invL = (cont_t)*proc_addr( p, IDX_PROC_CODE ); \
+       reg(0) = p; \
        RESULT = fixnum(n); \
        integrity_check( "invoke" ); \
         twobit_branch( -1, invL ); \
    } while(0)
 #endif
 
+/* GLOBAL/INVOKE with an inline cache.  Constant c is private to the
+   call site and holds the procedure last called through global g; it
+   starts out as the global's cell, which is never the global's value.
+   A hit needs neither the undefined-global check nor the procedure
+   check.  The cache is keyed on the cell's value, so setglbl (or any
+   other assignment to the global) invalidates it, and the collector
+   updates it along with the cell.
+   */
+#define twobit_global_invoke( g, c, n ) \
+  do { word p_ = global_cell_ref( get_const( g ) ); \
+       if (p_ != get_const( c )) { \
+         twobit_global( g ); \
+         p_ = RESULT; \
+         if (tagof(p_) != PROC_TAG) { \
+           FAIL( EX_NONPROC ); \
+         } \
+         else { \
+           SECOND = p_; \
+           RESULT = *proc_addr( reg(0), IDX_PROC_CONST ); \
+           *vec_addr( RESULT, c ) = p_; \
+           BARRIER(); \
+         } \
+       } \
+       twobit_invoke_proc( p_, n ); \
+  } while(0)
+
 #if USE_GOTOS_LOCALLY
 # define twobit_apply( k, l ) \
    do { SECOND=reg(k); THIRD=reg(l); \
@@ -584,6 +647,16 @@ extern cont_t twobit_cont_label;
 #    define nonlocal_control_transfer( REGZERO, L ) \
        do { globals[ G_EFFECTIVE_REG0 ] = REGZERO; \
             twobit_cont_label = (cont_t)L; SAVE_STATE(); return; } while(0)
+#  elif USE_MUSTTAIL
+     /* Enter the target procedure directly, as the dispatch loop in
+        scheme_start() would have done had we returned L to it. */
+#    define nonlocal_control_transfer( REGZERO, L ) \
+       do { word r0_ = REGZERO; \
+            globals[ G_EFFECTIVE_REG0 ] = r0_; SAVE_STATE(); \
+            MUSTTAIL return \
+              (DECODE_CODEPTR(procedure_ref(r0_,IDX_PROC_CODE)))( globals, \
+                                                               (cont_t)L ); \
+       } while(0)
 #  endif
 #endif
 
@@ -924,7 +997,7 @@ extern cont_t twobit_cont_label;
    twobit_subtract( RESULT, reg( y ), kn, k )
 
 #define twobit_op2_63( y, kn, k ) /* * */ \
-   implicit_label( SECOND = reg(y); mc_mul( globals, CONT_LOCAL(kn,k) ), kn, k )
+   twobit_multiply( RESULT, reg( y ), kn, k )
 
 #define twobit_op2_64( y, kn, k ) /* / */ \
    implicit_label( SECOND = reg(y); mc_div( globals, CONT_LOCAL(kn,k) ), kn, k )
@@ -1512,6 +1585,65 @@ extern cont_t twobit_cont_label;
 #define twobit_op2imm_523( y, kn, k ) /* -:fix:fix */ \
   twobit_subtract( RESULT, y, kn, k )
 
+/* Trusted flonum operations: both operands are known to be flonums.
+   When the result of one arithmetic operation is consumed directly by
+   the next, the assembler keeps it unboxed in a C double:
+
+     { double flt_ = twobit_flo_ref( RESULT );
+       twobit_flo_op2( flt_, *, 2 );
+       twobit_flo_op2( flt_, +, 3 );
+       twobit_flo_box( flt_ ); }
+
+   and only the last result is allocated.
+   */
+#define twobit_flo_ref( x ) \
+  (*(double*)((word)(x)-BVEC_TAG+2*sizeof(word)))
+
+#define twobit_flo_op2( d, op, y ) \
+  ((d) = (d) op twobit_flo_ref( reg(y) ))
+
+#define twobit_flo_box( d ) \
+  do { word *p; double d_ = d; \
+       ALLOCATE( 2*sizeof(word)+sizeof(double) ); \
+       p = (word*)RESULT; \
+       p[0] = mkheader( sizeof(word)+sizeof(double), FLONUM_HDR ); \
+       *(double*)(p+2) = d_; \
+       RESULT = tagptr( p, BVEC_TAG ); \
+  } while(0)
+
+#define twobit_flo_arith( op, y ) \
+  do { double flt_ = twobit_flo_ref( RESULT ); \
+       twobit_flo_op2( flt_, op, y ); \
+       twobit_flo_box( flt_ ); \
+  } while(0)
+
+#define twobit_op2_540( y ) /* +:flo:flo */ \
+  twobit_flo_arith( +, y )
+
+#define twobit_op2_541( y ) /* -:flo:flo */ \
+  twobit_flo_arith( -, y )
+
+#define twobit_op2_542( y ) /* *:flo:flo */ \
+  twobit_flo_arith( *, y )
+
+#define twobit_op2_543( y ) /* /:flo:flo */ \
+  twobit_flo_arith( /, y )
+
+#define twobit_op2_544( y ) /* =:flo:flo */ \
+  setcc( twobit_flo_ref( RESULT ) == twobit_flo_ref( reg(y) ) )
+
+#define twobit_op2_545( y ) /* <:flo:flo */ \
+  setcc( twobit_flo_ref( RESULT ) < twobit_flo_ref( reg(y) ) )
+
+#define twobit_op2_546( y ) /* <=:flo:flo */ \
+  setcc( twobit_flo_ref( RESULT ) <= twobit_flo_ref( reg(y) ) )
+
+#define twobit_op2_547( y ) /* >:flo:flo */ \
+  setcc( twobit_flo_ref( RESULT ) > twobit_flo_ref( reg(y) ) )
+
+#define twobit_op2_548( y ) /* >=:flo:flo */ \
+  setcc( twobit_flo_ref( RESULT ) >= twobit_flo_ref( reg(y) ) )
+
 
 /* Introduced by peephole optimization */
 #define twobit_alloc_known_vector( k )		\
@@ -183,6 +183,7 @@ void EXPORT mc_timer_exception( word *globals, cont_t k )
 
 static void timer_exception( word *globals, cont_t k )
 {
+  sampler_poll( globals );
   check_signals( globals, k );
   gc_incremental( the_gc( globals ) );
 
@@ -8,13 +8,21 @@
 #include "larceny-types.h"
 #include "millicode.h"
 
+#if !HAVE_OVERFLOW_BUILTINS
 static void neg64( word *, word * );
+#endif
 
 /* Multiply two 32-bit signed numbers and produce a 64-bit signed 
  * result. 
  */
 void mul_32x32_to_64( word a, word b, word *hi, word *lo )
 {
+#if HAVE_OVERFLOW_BUILTINS
+  /* Any compiler with the overflow builtins has a 64-bit long long. */
+  long long r = (long long)(s_word)a * (long long)(s_word)b;
+  *lo = (word)r;
+  *hi = (word)((unsigned long long)r >> 32);
+#else
   if ((s_word)a < 0) {
     if ((s_word)b < 0)
       umul_32x32_to_64( (word)-(s_word)a, (word)-(s_word)b, hi, lo );
@@ -29,6 +37,7 @@ void mul_32x32_to_64( word a, word b, word *hi, word *lo )
   }
   else 
     umul_32x32_to_64( a, b, hi, lo );
+#endif
 }
 
 /* Multiply two 32-bit unsigned numbers and produce a 64-bit unsigned
@@ -36,6 +45,11 @@ void mul_32x32_to_64( word a, word b, word *hi, word *lo )
  */
 void umul_32x32_to_64( word a, word b, word *hi, word *lo )
 {
+#if HAVE_OVERFLOW_BUILTINS
+  unsigned long long r = (unsigned long long)a * (unsigned long long)b;
+  *lo = (word)r;
+  *hi = (word)(r >> 32);
+#else
   word a1, a2, b1, b2, r1, r2, r3, r4, carry, x, y;
 
   a1 = a & 0xFFFF;
@@ -57,8 +71,10 @@ void umul_32x32_to_64( word a, word b, word *hi, word *lo )
   if (y < x) carry++;      
   *lo = y;
   *hi = r4 + (r2 >> 16) + (r3 >> 16) + carry;
+#endif
 }
 
+#if !HAVE_OVERFLOW_BUILTINS
 static void neg64( word *hi, word *lo )
 {
   word carry = 0, y;
@@ -68,6 +84,7 @@ static void neg64( word *hi, word *lo )
   *lo = y;
   *hi = ~*hi + carry;
 }
+#endif
 
 #if defined( MULTEST )
 struct test {
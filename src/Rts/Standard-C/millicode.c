@@ -139,6 +139,12 @@ void scheme_start( word *globals )
      is done in the block itself by means of a tail call.  Occasionally,
      the C stack must be pruned, and the block signals a timer interrupt
      (longjump with DISPATCH_TIMER).
+
+     When the jump discipline is USE_MUSTTAIL, the inner loop is the
+     same as for USE_RETURN_WITH_VALUE, but blocks transfer control
+     to each other by guaranteed tail calls and return to the loop
+     only on exceptional paths (after signalling an exception), so the
+     loop body is executed rarely and the C stack does not grow.
      */
 
   /* Outer loop */
@@ -201,7 +207,7 @@ void scheme_start( word *globals )
     * localized to the inner loop, because a stack underflow will
     * cause a jump to the outer loop, and REG0 must be preserved
     * across the jump.*/
-#  if USE_RETURN_WITH_VALUE
+#  if USE_RETURN_WITH_VALUE || USE_MUSTTAIL
    while (1)
    {
      codeptr_t p=DECODE_CODEPTR(procedure_ref((word *)globals[ G_EFFECTIVE_REG0 ],
@@ -436,6 +442,7 @@ void EXPORT mc_timer_exception( word *globals, cont_t k )
 
 static void timer_exception( word *globals, cont_t k )
 {
+  sampler_poll( globals );
   check_signals( globals, k );
   gc_incremental( the_gc( globals ) );
 
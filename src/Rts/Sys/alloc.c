@@ -110,6 +110,8 @@ static struct {
   unsigned     smircy_bytes;         /* bytes allocated to marking state */
   unsigned     max_smircy_bytes;     /* max ditto */
   unsigned     peak_smircy_bytes;    /* max_mem_bytes ditto */
+  unsigned     pinned_bytes;         /* heap bytes holding pinned objects */
+  unsigned     max_pinned_bytes;     /* max ditto */
   unsigned     rts_bytes;            /* bytes allocated to RTS "other" */
   unsigned     max_rts_bytes;        /* max ditto */
   unsigned     peak_rts_bytes;       /* max_mem_bytes ditto */
@@ -121,6 +123,7 @@ static struct {
 } data;
 
 static byte *gclib_alloc( unsigned bytes );
+static void cover_range( byte *ptr, unsigned bytes );
 #if !GCLIB_LARGE_TABLE
 static void allocation_below_membot( byte *ptr, int bytes );
 static void allocation_above_memtop( byte *ptr, int bytes );
@@ -291,11 +294,18 @@ static void update_mem_bytes( void )
  */
 static byte *gclib_alloc( unsigned bytes )
 {
-  byte *ptr, *top;
+  byte *ptr;
   
   assert( ( bytes % PAGESIZE) == 0 );
   ptr = alloc_aligned( bytes );
-  top = ptr+bytes;
+  cover_range( ptr, bytes );
+  return ptr;
+}
+
+/* Make the page tables cover the block [ptr, ptr+bytes). */
+static void cover_range( byte *ptr, unsigned bytes )
+{
+  byte *top = ptr+bytes;
 
 #if GCLIB_LARGE_TABLE
   if (data.membot == 0 || ptr < data.membot) data.membot = ptr;
@@ -313,8 +323,6 @@ static byte *gclib_alloc( unsigned bytes )
   else if (top > data.memtop)
     allocation_above_memtop( ptr, bytes );
 #endif
-  
-  return ptr;
 }
 
 #if !GCLIB_LARGE_TABLE
@@ -462,6 +470,8 @@ void gclib_free( void *addr, int bytes )
     else
       data.heap_bytes -= bytes;
 #else
+    if (gclib_desc_b[pageno] & MB_PINNED)
+      data.pinned_bytes -= bytes;
     if (gclib_desc_b[pageno] & MB_HEAP_MEMORY)
       data.heap_bytes -= bytes;
     else if (gclib_desc_b[pageno] & MB_REMSET)
@@ -489,6 +499,48 @@ void gclib_free( void *addr, int bytes )
   update_mem_bytes();
 }
 
+#if !GCLIB_LARGE_TABLE
+/* A mapped block was not obtained from alloc_aligned() and is not
+   charged to the heap.  Its first page holds the large object's header
+   and looks like heap memory to the collector; the rest of the block
+   belongs to no generation.
+   */
+void gclib_add_mapped( void *addr, int bytes, int gen_no )
+{
+  int i;
+
+  assert( (word)addr % PAGESIZE == 0 && bytes % PAGESIZE == 0 );
+
+  cover_range( (byte*)addr, bytes );
+  i = pageof( addr );
+  gclib_desc_g[i] = gen_no;
+  gclib_desc_b[i] =
+    MB_ALLOCATED | MB_HEAP_MEMORY | MB_LARGE_OBJECT | MB_MAPPED_FILE;
+  for ( i++ ; i < pageof( (byte*)addr+bytes ) ; i++ ) {
+    gclib_desc_g[i] = RTS_OWNED_PAGE;
+    gclib_desc_b[i] = MB_ALLOCATED | MB_MAPPED_FILE;
+  }
+
+  supremely_annoyingmsg( "Added mapped memory gen=%d bytes=%d addr=[0x%08x,0x%08x)",
+			 gen_no, bytes, addr, (void*)((byte*)addr+bytes) );
+}
+
+void gclib_free_mapped( void *addr, int bytes )
+{
+  int i;
+
+  supremely_annoyingmsg( "Freeing mapped memory: bytes=%d addr=[0x%08x,0x%08x)",
+			 bytes, addr, (void*)((byte*)addr+bytes) );
+
+  osdep_unmapfile( addr, bytes );
+  for ( i = pageof( addr ) ; i < pageof( (byte*)addr+bytes ) ; i++ ) {
+    assert( gclib_desc_b[i] & MB_MAPPED_FILE );
+    gclib_desc_b[i] = MB_FOREIGN;
+    gclib_desc_g[i] = UNALLOCATED_PAGE;
+  }
+}
+#endif
+
 void gclib_shrink_block( void *p, int oldsize, int newsize )
 {
   assert( oldsize >= newsize );
@@ -526,6 +578,21 @@ void gclib_add_attribute( void *address, int nbytes, unsigned attr )
   }
 }
 
+void gclib_add_pinned( void *address, int nbytes )
+{
+#if !GCLIB_LARGE_TABLE
+  int p;
+
+  for ( p = pageof( address ) ; p <= pageof( (byte*)address+nbytes-1 ) ; p++ )
+    if (!(gclib_desc_b[p] & MB_PINNED)) {
+      assert( gclib_desc_b[p] & MB_LARGE_OBJECT );
+      gclib_desc_b[p] |= MB_PINNED;
+      data.pinned_bytes += PAGESIZE;
+    }
+  data.max_pinned_bytes = max( data.max_pinned_bytes, data.pinned_bytes );
+#endif
+}
+
 void gclib_stats( gclib_stats_t *stats )
 {
   stats->heap_allocated         = bytes2words( data.heap_bytes );
@@ -536,6 +603,8 @@ void gclib_stats( gclib_stats_t *stats )
   stats->summ_allocated_max     = bytes2words( data.max_summ_bytes );
   stats->smircy_allocated       = bytes2words( data.smircy_bytes );
   stats->smircy_allocated_max   = bytes2words( data.max_smircy_bytes );
+  stats->pinned_allocated       = bytes2words( data.pinned_bytes );
+  stats->pinned_allocated_max   = bytes2words( data.max_pinned_bytes );
   stats->rts_allocated          = bytes2words( data.rts_bytes );
   stats->rts_allocated_max      = bytes2words( data.max_rts_bytes );
   stats->heap_fragmentation     = bytes2words( data.wastage_bytes );
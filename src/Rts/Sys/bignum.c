@@ -0,0 +1,1157 @@
+/* Copyright 2026 The Larceny Project.
+ *
+ * $Id$
+ *
+ * Larceny run-time system -- bignum kernels.
+ *
+ * The generic arithmetic in Lib/Common/bignums.sch calls in here, through
+ * the bignum-op syscall, once its operands are larger than a few words.
+ * The kernels work on the digits of a bignum as 32-bit limbs, least
+ * significant first, which is how Larceny lays them out on all targets
+ * (see the comment at the head of Lib/Common/bignums-el.sch):
+ *
+ *   add, subtract       linear
+ *   multiply            schoolbook, Karatsuba above KARATSUBA_THRESHOLD
+ *                       limbs, Toom-3 above TOOM3_THRESHOLD
+ *   divide              Knuth's algorithm D, and the recursive division
+ *                       of Burnikel and Ziegler above BZ_THRESHOLD
+ *   gcd                 Lehmer's algorithm (Knuth 4.5.2, algorithm L)
+ *   radix conversion    divide and conquer by repeated squares of the
+ *                       radix above RADIX_THRESHOLD; bit extraction for
+ *                       powers of two
+ *
+ * The Scheme code allocates every result before calling in, with room
+ * for the largest possible value, and checks the types; the kernels
+ * store the magnitude, set the length and make the sign positive, and
+ * the Scheme code then fixes the sign and normalizes.  Temporaries are
+ * allocated with malloc.  Nothing here allocates in the Scheme heap, so
+ * the pointers into the operands stay valid throughout.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "larceny.h"
+
+/* Operations; must agree with Lib/Common/bignums.sch. */
+
+#define BIG_ADD       0
+#define BIG_SUB       1
+#define BIG_MUL       2
+#define BIG_DIVREM    3
+#define BIG_GCD       4
+#define BIG_TOSTRING  5
+
+/* Crossover points, in limbs. */
+
+#define KARATSUBA_THRESHOLD  32
+#define TOOM3_THRESHOLD      160
+#define BZ_THRESHOLD         48
+#define RADIX_THRESHOLD      32
+
+typedef unsigned long long dword;
+
+#define big_digits( w )    (ptrof( w )+2)
+#define big_capacity( w )  ((int)(bytevector_length( w ) / 4) - 1)
+
+static int min_int( int a, int b ) { return a < b ? a : b; }
+
+/* Operations on limb vectors.  Results may overlap the operands exactly
+   except where noted. */
+
+static int normalize( word *a, int n )
+{
+  while (n > 0 && a[n-1] == 0)
+    n--;
+  return n;
+}
+
+static int leading_zeros( word x )
+{
+  int n = 0;
+
+  if (x == 0) return 32;
+  while (!(x & 0x80000000)) {
+    x <<= 1;
+    n++;
+  }
+  return n;
+}
+
+static int cmp_n( word *a, word *b, int n )
+{
+  while (--n >= 0)
+    if (a[n] != b[n])
+      return a[n] < b[n] ? -1 : 1;
+  return 0;
+}
+
+static word add_n( word *r, word *a, word *b, int n )
+{
+  dword t = 0;
+  int i;
+
+  for ( i=0 ; i < n ; i++ ) {
+    t += (dword)a[i] + b[i];
+    r[i] = (word)t;
+    t >>= 32;
+  }
+  return (word)t;
+}
+
+static word add_1( word *r, word *a, int n, word c )
+{
+  int i;
+
+  for ( i=0 ; i < n ; i++ ) {
+    dword t = (dword)a[i] + c;
+    r[i] = (word)t;
+    c = (word)(t >> 32);
+  }
+  return c;
+}
+
+/* r = a + b, where an >= bn; r has an limbs, returns the carry. */
+
+static word add( word *r, word *a, int an, word *b, int bn )
+{
+  return add_1( r+bn, a+bn, an-bn, add_n( r, a, b, bn ) );
+}
+
+static word sub_n( word *r, word *a, word *b, int n )
+{
+  word borrow = 0;
+  int i;
+
+  for ( i=0 ; i < n ; i++ ) {
+    dword t = (dword)a[i] - b[i] - borrow;
+    r[i] = (word)t;
+    borrow = (word)(t >> 32) & 1;
+  }
+  return borrow;
+}
+
+static word sub_1( word *r, word *a, int n, word borrow )
+{
+  int i;
+
+  for ( i=0 ; i < n ; i++ ) {
+    dword t = (dword)a[i] - borrow;
+    r[i] = (word)t;
+    borrow = (word)(t >> 32) & 1;
+  }
+  return borrow;
+}
+
+/* r = a - b, where an >= bn; returns the borrow. */
+
+static word sub( word *r, word *a, int an, word *b, int bn )
+{
+  return sub_1( r+bn, a+bn, an-bn, sub_n( r, a, b, bn ) );
+}
+
+/* r = |a - b| where an >= bn; r has an limbs.  Returns 1 if a < b. */
+
+static int diff( word *r, word *a, int an, word *b, int bn )
+{
+  int i;
+
+  for ( i=an-1 ; i >= bn && a[i] == 0 ; i-- )
+    r[i] = 0;
+  if (i < bn && cmp_n( a, b, bn ) < 0) {
+    sub_n( r, b, a, bn );
+    return 1;
+  }
+  sub( r, a, an, b, bn );
+  return 0;
+}
+
+static word mul_1( word *r, word *a, int n, word k )
+{
+  dword t = 0;
+  int i;
+
+  for ( i=0 ; i < n ; i++ ) {
+    t += (dword)a[i] * k;
+    r[i] = (word)t;
+    t >>= 32;
+  }
+  return (word)t;
+}
+
+static word addmul_1( word *r, word *a, int n, word k )
+{
+  dword t = 0;
+  int i;
+
+  for ( i=0 ; i < n ; i++ ) {
+    t += (dword)a[i] * k + r[i];
+    r[i] = (word)t;
+    t >>= 32;
+  }
+  return (word)t;
+}
+
+static word submul_1( word *r, word *a, int n, word k )
+{
+  word carry = 0;
+  int i;
+
+  for ( i=0 ; i < n ; i++ ) {
+    dword p = (dword)a[i] * k + carry;
+    word lo = (word)p, ri = r[i];
+
+    carry = (word)(p >> 32);
+    r[i] = ri - lo;
+    if (ri < lo)
+      carry++;
+  }
+  return carry;
+}
+
+/* q = a / d, returns a mod d.  q may be a. */
+
+static word divrem_1( word *q, word *a, int n, word d )
+{
+  dword rem = 0;
+  int i;
+
+  for ( i=n-1 ; i >= 0 ; i-- ) {
+    dword t = (rem << 32) | a[i];
+    q[i] = (word)(t / d);
+    rem = t % d;
+  }
+  return (word)rem;
+}
+
+/* r = a << s and r = a >> s, for 0 <= s < 32; return the bits shifted
+   out. */
+
+static word lshift( word *r, word *a, int n, int s )
+{
+  word out = 0;
+  int i;
+
+  if (s == 0) {
+    memmove( r, a, n*sizeof( word ) );
+    return 0;
+  }
+  for ( i=n-1 ; i >= 0 ; i-- ) {
+    word x = a[i];
+    if (i == n-1)
+      out = x >> (32-s);
+    r[i] = (x << s) | (i > 0 ? a[i-1] >> (32-s) : 0);
+  }
+  return out;
+}
+
+static void rshift( word *r, word *a, int n, int s )
+{
+  int i;
+
+  if (s == 0) {
+    memmove( r, a, n*sizeof( word ) );
+    return;
+  }
+  for ( i=0 ; i < n ; i++ )
+    r[i] = (a[i] >> s) | (i+1 < n ? a[i+1] << (32-s) : 0);
+}
+
+/* Multiplication.  The result r must not overlap the operands. */
+
+static void mul_basecase( word *r, word *a, int an, word *b, int bn )
+{
+  int i;
+
+  r[an] = mul_1( r, a, an, b[0] );
+  for ( i=1 ; i < bn ; i++ )
+    r[an+i] = addmul_1( r+i, a, an, b[i] );
+}
+
+/* Workspace needed by karatsuba() for n limbs. */
+
+static int karatsuba_space( int n )
+{
+  int s = 0;
+
+  while (n >= KARATSUBA_THRESHOLD) {
+    n = (n+1)/2;
+    s += 6*n+1;
+  }
+  return s;
+}
+
+/* r = a * b, all of n limbs, with
+ *
+ *   a b = (B^2l + B^l) a1 b1 + (B^l + 1) a0 b0 - B^l (a0 - a1)(b0 - b1)
+ *
+ * where a = a1 B^l + a0 and likewise for b.  a0 b0 and a1 b1 go straight
+ * into the low and high halves of r; the middle term is accumulated in
+ * the workspace and added in.
+ */
+
+static void karatsuba( word *r, word *a, word *b, int n, word *ws )
+{
+  int l = (n+1)/2, h = n-l, len;
+  word *da = ws, *db = ws+l, *d = ws+2*l, *mid = ws+4*l, *rest = ws+6*l+1;
+  int sa, sb;
+
+  if (n < KARATSUBA_THRESHOLD) {
+    mul_basecase( r, a, n, b, n );
+    return;
+  }
+  sa = diff( da, a, l, a+l, h );
+  sb = diff( db, b, l, b+l, h );
+  karatsuba( r, a, b, l, rest );
+  karatsuba( r+2*l, a+l, b+l, h, rest );
+  karatsuba( d, da, db, l, rest );
+
+  mid[2*l] = add( mid, r, 2*l, r+2*l, 2*h );
+  if (sa == sb)
+    mid[2*l] -= sub_n( mid, mid, d, 2*l );
+  else
+    mid[2*l] += add_n( mid, mid, d, 2*l );
+
+  /* The middle term is less than B^(2n-l), so the limbs beyond that
+     are zero. */
+  len = min_int( 2*l+1, 2*n-l );
+  add_1( r+l+len, r+l+len, 2*n-l-len, add_n( r+l, r+l, mid, len ) );
+}
+
+static void toom3( word *r, word *a, word *b, int n );
+
+static void mul_n( word *r, word *a, word *b, int n )
+{
+  if (n < KARATSUBA_THRESHOLD)
+    mul_basecase( r, a, n, b, n );
+  else if (n < TOOM3_THRESHOLD) {
+    word *ws = (word*)must_malloc( karatsuba_space( n )*sizeof( word ) );
+    karatsuba( r, a, b, n, ws );
+    free( ws );
+  }
+  else
+    toom3( r, a, b, n );
+}
+
+/* r = a * b where an >= bn >= 1; r has an+bn limbs.  An unbalanced
+   product is done as a row of balanced ones. */
+
+static void mul( word *r, word *a, int an, word *b, int bn )
+{
+  word *t;
+  int i, k;
+
+  if (bn < KARATSUBA_THRESHOLD) {
+    mul_basecase( r, a, an, b, bn );
+    return;
+  }
+  if (an == bn) {
+    mul_n( r, a, b, an );
+    return;
+  }
+  t = (word*)must_malloc( 2*bn*sizeof( word ) );
+  memset( r, 0, (an+bn)*sizeof( word ) );
+  for ( i=0 ; i < an ; i += bn ) {
+    k = min_int( bn, an-i );
+    if (k == bn)
+      mul_n( t, a+i, b, bn );
+    else
+      mul( t, b, bn, a+i, k );
+    add( r+i, r+i, an+bn-i, t, k+bn );
+  }
+  free( t );
+}
+
+/* Natural numbers in malloc'd storage, for the algorithms that need
+   intermediate values of varying size.  n is the number of significant
+   limbs.  The sign is used only by the Toom-3 interpolation. */
+
+typedef struct {
+  word *d;
+  int  n;
+  int  neg;
+} nat;
+
+static word zero_limb;
+static const nat nat_zero = { &zero_limb, 0, 0 };
+
+static nat nat_alloc( int n )
+{
+  nat x;
+
+  x.d = (word*)must_malloc( (n > 0 ? n : 1)*sizeof( word ) );
+  x.n = n;
+  x.neg = 0;
+  return x;
+}
+
+static nat nat_fix( nat x )
+{
+  x.n = normalize( x.d, x.n );
+  if (x.n == 0)
+    x.neg = 0;
+  return x;
+}
+
+/* Limbs lo up to hi of d[0..n), as a new number. */
+
+static nat nat_slice( word *d, int n, int lo, int hi )
+{
+  nat x;
+
+  hi = min_int( hi, n );
+  x = nat_alloc( hi > lo ? hi-lo : 0 );
+  if (x.n > 0)
+    memcpy( x.d, d+lo, x.n*sizeof( word ) );
+  return nat_fix( x );
+}
+
+static nat nat_copy( nat a )
+{
+  nat x = nat_slice( a.d, a.n, 0, a.n );
+  x.neg = a.neg;
+  return x;
+}
+
+static void nat_free( nat x )
+{
+  free( x.d );
+}
+
+static int nat_cmp( nat a, nat b )
+{
+  if (a.n != b.n)
+    return a.n < b.n ? -1 : 1;
+  return cmp_n( a.d, b.d, a.n );
+}
+
+/* |a| + |b| and |a| - |b|, the latter for |a| >= |b|. */
+
+static nat nat_add( nat a, nat b )
+{
+  nat r;
+
+  if (a.n < b.n) {
+    nat t = a; a = b; b = t;
+  }
+  r = nat_alloc( a.n+1 );
+  r.d[a.n] = add( r.d, a.d, a.n, b.d, b.n );
+  return nat_fix( r );
+}
+
+static nat nat_sub( nat a, nat b )
+{
+  nat r = nat_alloc( a.n );
+
+  sub( r.d, a.d, a.n, b.d, b.n );
+  return nat_fix( r );
+}
+
+static nat nat_mul( nat a, nat b )
+{
+  nat r;
+
+  if (a.n == 0 || b.n == 0)
+    return nat_alloc( 0 );
+  r = nat_alloc( a.n+b.n );
+  if (a.n >= b.n)
+    mul( r.d, a.d, a.n, b.d, b.n );
+  else
+    mul( r.d, b.d, b.n, a.d, a.n );
+  r.neg = a.neg != b.neg;
+  return nat_fix( r );
+}
+
+/* a * B^k + b, where b < B^k. */
+
+static nat nat_join( nat a, int k, nat b )
+{
+  nat r = nat_alloc( a.n > 0 ? a.n+k : b.n );
+
+  memset( r.d, 0, r.n*sizeof( word ) );
+  memcpy( r.d, b.d, b.n*sizeof( word ) );
+  memcpy( r.d+k, a.d, a.n*sizeof( word ) );
+  return nat_fix( r );
+}
+
+/* Signed sum and difference. */
+
+static nat s_add( nat a, nat b )
+{
+  nat r;
+
+  if (a.neg == b.neg) {
+    r = nat_add( a, b );
+    r.neg = a.neg;
+  }
+  else if (nat_cmp( a, b ) >= 0) {
+    r = nat_sub( a, b );
+    r.neg = a.neg;
+  }
+  else {
+    r = nat_sub( b, a );
+    r.neg = b.neg;
+  }
+  return nat_fix( r );
+}
+
+static nat s_sub( nat a, nat b )
+{
+  b.neg = !b.neg;
+  return s_add( a, b );
+}
+
+/* Toom-3: a and b are split into three parts of k limbs, seen as
+ * polynomials in x = B^k, evaluated at 0, 1, -1, -2 and infinity,
+ * multiplied pointwise, and the product interpolated with Bodrato's
+ * sequence of exact divisions.
+ */
+
+static nat toom3_eval( nat *m, nat *p1, nat *pm1 )
+{
+  nat t = nat_add( m[0], m[2] ), u, pm2;
+
+  *p1 = nat_add( t, m[1] );
+  *pm1 = s_sub( t, m[1] );
+  nat_free( t );
+  t = s_add( *pm1, m[2] );                       /* (p(-1) + m2) 2 - m0 */
+  u = nat_alloc( t.n+1 );
+  u.d[t.n] = lshift( u.d, t.d, t.n, 1 );
+  u.neg = t.neg;
+  u = nat_fix( u );
+  pm2 = s_sub( u, m[0] );
+  nat_free( t );
+  nat_free( u );
+  return pm2;
+}
+
+static void nat_halve( nat *x )
+{
+  rshift( x->d, x->d, x->n, 1 );
+  *x = nat_fix( *x );
+}
+
+static void add_at( word *r, int rn, nat c, int off )
+{
+  int len = min_int( c.n, rn-off );
+
+  if (len > 0)
+    add_1( r+off+len, r+off+len, rn-off-len,
+           add_n( r+off, r+off, c.d, len ) );
+}
+
+static void toom3( word *r, word *a, word *b, int n )
+{
+  int k = (n+2)/3, i;
+  nat am[3], bm[3], p1, pm1, pm2, q1, qm1, qm2;
+  nat r0, r1, rm1, rm2, rinf, c1, c2, c3, t, u;
+
+  for ( i=0 ; i < 3 ; i++ ) {
+    am[i] = nat_slice( a, n, i*k, (i+1)*k );
+    bm[i] = nat_slice( b, n, i*k, (i+1)*k );
+  }
+  pm2 = toom3_eval( am, &p1, &pm1 );
+  qm2 = toom3_eval( bm, &q1, &qm1 );
+
+  r0 = nat_mul( am[0], bm[0] );
+  r1 = nat_mul( p1, q1 );
+  rm1 = nat_mul( pm1, qm1 );
+  rm2 = nat_mul( pm2, qm2 );
+  rinf = nat_mul( am[2], bm[2] );
+
+  c3 = s_sub( rm2, r1 );                         /* (r(-2) - r(1)) / 3 */
+  divrem_1( c3.d, c3.d, c3.n, 3 );
+  c3 = nat_fix( c3 );
+  c1 = s_sub( r1, rm1 );                         /* (r(1) - r(-1)) / 2 */
+  nat_halve( &c1 );
+  c2 = s_sub( rm1, r0 );                         /* r(-1) - r(0) */
+  t = s_sub( c2, c3 );                           /* (c2 - c3)/2 + 2 r(inf) */
+  nat_halve( &t );
+  nat_free( c3 );
+  u = s_add( t, rinf );
+  c3 = s_add( u, rinf );
+  nat_free( t );
+  nat_free( u );
+  t = s_add( c2, c1 );                           /* c2 + c1 - r(inf) */
+  nat_free( c2 );
+  c2 = s_sub( t, rinf );
+  nat_free( t );
+  t = s_sub( c1, c3 );                           /* c1 - c3 */
+  nat_free( c1 );
+  c1 = t;
+
+  memset( r, 0, 2*n*sizeof( word ) );
+  memcpy( r, r0.d, r0.n*sizeof( word ) );
+  memcpy( r+4*k, rinf.d, rinf.n*sizeof( word ) );
+  add_at( r, 2*n, c1, k );
+  add_at( r, 2*n, c2, 2*k );
+  add_at( r, 2*n, c3, 3*k );
+
+  for ( i=0 ; i < 3 ; i++ ) {
+    nat_free( am[i] );
+    nat_free( bm[i] );
+  }
+  nat_free( p1 ); nat_free( pm1 ); nat_free( pm2 );
+  nat_free( q1 ); nat_free( qm1 ); nat_free( qm2 );
+  nat_free( r0 ); nat_free( r1 ); nat_free( rm1 ); nat_free( rm2 );
+  nat_free( rinf );
+  nat_free( c1 ); nat_free( c2 ); nat_free( c3 );
+}
+
+/* Division. */
+
+/* Knuth's algorithm D: q = u / v and r = u mod v, where m >= n >= 2
+   and v[n-1] != 0.  q has m-n+1 limbs and r has n. */
+
+static void divrem_basecase( word *q, word *r, word *u, int m, word *v, int n )
+{
+  int s = leading_zeros( v[n-1] ), j;
+  word *un = (word*)must_malloc( (m+1)*sizeof( word ) );
+  word *vn = (word*)must_malloc( n*sizeof( word ) );
+
+  lshift( vn, v, n, s );
+  un[m] = lshift( un, u, m, s );
+  for ( j=m-n ; j >= 0 ; j-- ) {
+    dword num = ((dword)un[j+n] << 32) | un[j+n-1];
+    dword qhat = num / vn[n-1];
+    dword rhat = num % vn[n-1];
+    word borrow, hi;
+
+    while (qhat >> 32
+           || qhat * vn[n-2] > ((rhat << 32) | un[j+n-2])) {
+      qhat--;
+      rhat += vn[n-1];
+      if (rhat >> 32)
+        break;
+    }
+    borrow = submul_1( un+j, vn, n, (word)qhat );
+    hi = un[j+n];
+    un[j+n] = hi - borrow;
+    if (hi < borrow) {
+      qhat--;
+      un[j+n] += add_n( un+j, un+j, vn, n );
+    }
+    q[j] = (word)qhat;
+  }
+  rshift( r, un, n, s );
+  free( un );
+  free( vn );
+}
+
+static void nat_divrem_small( nat a, nat b, nat *q, nat *r )
+{
+  if (nat_cmp( a, b ) < 0) {
+    *q = nat_alloc( 0 );
+    *r = nat_copy( a );
+  }
+  else if (b.n == 1) {
+    *q = nat_alloc( a.n );
+    *r = nat_alloc( 1 );
+    r->d[0] = divrem_1( q->d, a.d, a.n, b.d[0] );
+    *q = nat_fix( *q );
+    *r = nat_fix( *r );
+  }
+  else {
+    *q = nat_alloc( a.n-b.n+1 );
+    *r = nat_alloc( b.n );
+    divrem_basecase( q->d, r->d, a.d, a.n, b.d, b.n );
+    *q = nat_fix( *q );
+    *r = nat_fix( *r );
+  }
+}
+
+/* Burnikel and Ziegler, "Fast recursive division", 1998, in the form
+ * where a 2n by n limb division is two 3n/2 by n divisions, each of
+ * which is an n by n/2 division and a multiplication.  The divisor b
+ * has n limbs and its top bit set; a < b B^n.
+ */
+
+static void div2n1n( nat a, nat b, int n, nat *q, nat *r );
+
+static void div3n2n( nat a12, nat a3, nat b, nat b1, nat b2, int n,
+                     nat *q, nat *r )
+{
+  nat hi = nat_slice( a12.d, a12.n, n, 2*n ), t, p, u;
+
+  if (nat_cmp( hi, b1 ) == 0) {
+    int i;
+
+    /* q = B^n - 1, r = a12 - b1 B^n + b1 */
+    *q = nat_alloc( n );
+    for ( i=0 ; i < n ; i++ )
+      q->d[i] = 0xFFFFFFFF;
+    t = nat_add( a12, b1 );
+    u = nat_join( b1, n, nat_zero );
+    *r = nat_sub( t, u );
+    nat_free( t );
+    nat_free( u );
+  }
+  else
+    div2n1n( a12, b1, n, q, r );
+  nat_free( hi );
+
+  t = nat_join( *r, n, a3 );
+  p = nat_mul( *q, b2 );
+  nat_free( *r );
+  while (nat_cmp( t, p ) < 0) {
+    sub_1( q->d, q->d, q->n, 1 );
+    *q = nat_fix( *q );
+    u = nat_add( t, b );
+    nat_free( t );
+    t = u;
+  }
+  *r = nat_sub( t, p );
+  nat_free( t );
+  nat_free( p );
+}
+
+static void div2n1n( nat a, nat b, int n, nat *q, nat *r )
+{
+  nat a1, a2, a3, b1, b2, q1, q2, r1;
+  int pad = n & 1, half;
+
+  if (n < BZ_THRESHOLD) {
+    nat_divrem_small( a, b, q, r );
+    return;
+  }
+  if (pad) {                                    /* Make n even */
+    a = nat_join( a, 1, nat_zero );
+    b = nat_join( b, 1, nat_zero );
+    n++;
+  }
+  half = n/2;
+  b1 = nat_slice( b.d, b.n, half, n );
+  b2 = nat_slice( b.d, b.n, 0, half );
+  a1 = nat_slice( a.d, a.n, n, 2*n );
+  a2 = nat_slice( a.d, a.n, half, n );
+  a3 = nat_slice( a.d, a.n, 0, half );
+  div3n2n( a1, a2, b, b1, b2, half, &q1, &r1 );
+  div3n2n( r1, a3, b, b1, b2, half, &q2, r );
+  *q = nat_join( q1, half, q2 );
+  nat_free( a1 ); nat_free( a2 ); nat_free( a3 );
+  nat_free( b1 ); nat_free( b2 );
+  nat_free( q1 ); nat_free( q2 ); nat_free( r1 );
+  if (pad) {
+    nat t = nat_slice( r->d, r->n, 1, r->n );
+    nat_free( *r );
+    *r = t;
+    nat_free( a );
+    nat_free( b );
+  }
+}
+
+/* q = a / b, r = a mod b, b != 0.  With the divisor normalized, the
+   dividend is processed in digits of n = |b| limbs, each step a 2n by
+   n division. */
+
+static void nat_divrem( nat a, nat b, nat *q, nat *r )
+{
+  nat an, bn, x, digit, qd, rd;
+  int s, n, i, count;
+
+  if (b.n < BZ_THRESHOLD || a.n - b.n < BZ_THRESHOLD) {
+    nat_divrem_small( a, b, q, r );
+    return;
+  }
+  s = leading_zeros( b.d[b.n-1] );
+  bn = nat_alloc( b.n );
+  lshift( bn.d, b.d, b.n, s );
+  an = nat_alloc( a.n+1 );
+  an.d[a.n] = lshift( an.d, a.d, a.n, s );
+  an = nat_fix( an );
+  n = bn.n;
+  count = (an.n + n - 1) / n;
+
+  *q = nat_alloc( count*n );
+  memset( q->d, 0, q->n*sizeof( word ) );
+  rd = nat_copy( nat_zero );
+  for ( i=count-1 ; i >= 0 ; i-- ) {
+    digit = nat_slice( an.d, an.n, i*n, (i+1)*n );
+    x = nat_join( rd, n, digit );
+    nat_free( rd );
+    nat_free( digit );
+    div2n1n( x, bn, n, &qd, &rd );
+    memcpy( q->d+i*n, qd.d, qd.n*sizeof( word ) );
+    nat_free( qd );
+    nat_free( x );
+  }
+  *q = nat_fix( *q );
+  rshift( rd.d, rd.d, rd.n, s );
+  *r = nat_fix( rd );
+  nat_free( an );
+  nat_free( bn );
+}
+
+/* Greatest common divisor by Lehmer's method: the quotients of the
+ * Euclidean algorithm are found from the leading 62 bits of u and v
+ * for as long as they are certain and the cofactors fit in a limb,
+ * and applied to u and v as one linear combination.  Takes ownership
+ * of u and v.
+ */
+
+#define LEHMER_LIMIT  0x100000000LL
+
+/* x u + y v, where x and y are cofactors from the loop below: less than
+   2^32 in magnitude, of opposite signs or one of them zero, and such
+   that the result is not negative. */
+
+static nat nat_lincomb( nat u, long long x, nat v, long long y )
+{
+  nat p, q, r;
+  word a, b;
+  int n;
+
+  if (x >= 0 && y <= 0) {
+    p = u; a = (word)x; q = v; b = (word)-y;
+  }
+  else {
+    p = v; a = (word)y; q = u; b = (word)-x;
+  }
+  n = (p.n > q.n ? p.n : q.n) + 1;
+  r = nat_alloc( n );
+  memset( r.d, 0, n*sizeof( word ) );
+  r.d[p.n] = mul_1( r.d, p.d, p.n, a );
+  sub_1( r.d+q.n, r.d+q.n, n-q.n, submul_1( r.d, q.d, q.n, b ) );
+  return nat_fix( r );
+}
+
+/* floor(x / 2^p), for x < 2^(p+62). */
+
+static long long high_bits( nat x, int p )
+{
+  int i = p / 32, off = p % 32;
+  dword d0 = i < x.n ? x.d[i] : 0;
+  dword d1 = i+1 < x.n ? x.d[i+1] : 0;
+  dword d2 = i+2 < x.n ? x.d[i+2] : 0;
+  dword h = (d0 >> off) | (d1 << (32-off));
+
+  if (off > 0)
+    h |= d2 << (64-off);
+  return (long long)h;
+}
+
+static nat nat_gcd( nat u, nat v )
+{
+  nat t, q, r;
+
+  if (nat_cmp( u, v ) < 0) {
+    t = u; u = v; v = t;
+  }
+  while (v.n > 0) {
+    if (u.n <= 2) {
+      dword a = u.d[0] | (u.n > 1 ? (dword)u.d[1] << 32 : 0);
+      dword b = v.d[0] | (v.n > 1 ? (dword)v.d[1] << 32 : 0);
+
+      while (b != 0) {
+        dword c = a % b;
+        a = b;
+        b = c;
+      }
+      nat_free( u );
+      u = nat_alloc( 2 );
+      u.d[0] = (word)a;
+      u.d[1] = (word)(a >> 32);
+      u = nat_fix( u );
+      break;
+    }
+    if (v.n < u.n) {
+      nat_divrem( u, v, &q, &r );
+      nat_free( q );
+      nat_free( u );
+      u = v;
+      v = r;
+    }
+    else {
+      int p = 32*u.n - leading_zeros( u.d[u.n-1] ) - 62;
+      long long uh = high_bits( u, p ), vh = high_bits( v, p );
+      long long A = 1, B = 0, C = 0, D = 1, qq, T, TD;
+
+      for (;;) {
+        if (vh + C <= 0 || vh + D <= 0)
+          break;
+        qq = (uh + A) / (vh + C);
+        if (qq != (uh + B) / (vh + D))
+          break;
+        T = A - qq*C;
+        TD = B - qq*D;
+        if (T <= -LEHMER_LIMIT || T >= LEHMER_LIMIT
+            || TD <= -LEHMER_LIMIT || TD >= LEHMER_LIMIT)
+          break;
+        A = C; C = T;
+        B = D; D = TD;
+        T = uh - qq*vh; uh = vh; vh = T;
+      }
+      if (B == 0) {
+        nat_divrem( u, v, &q, &r );
+        nat_free( q );
+        nat_free( u );
+        u = v;
+        v = r;
+      }
+      else {
+        t = nat_lincomb( u, A, v, B );
+        r = nat_lincomb( u, C, v, D );
+        nat_free( u );
+        nat_free( v );
+        u = t;
+        v = r;
+      }
+    }
+    if (nat_cmp( u, v ) < 0) {
+      t = u; u = v; v = t;
+    }
+  }
+  nat_free( v );
+  return u;
+}
+
+/* Radix conversion.  x is split around radix^(k 2^i), where radix^k is
+   the largest power of the radix in a limb; the powers are made by
+   repeated squaring.  The low half of each split is written with
+   exactly k 2^i digits. */
+
+static const char digit_chars[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+typedef struct {
+  int  radix;
+  int  k;                       /* digits per limb */
+  word base;                    /* radix^k */
+  nat  pw[32];                  /* pw[i] = base^(2^i) */
+} radix_t;
+
+static char *radix_basecase( radix_t *rx, nat x, int pad, char *out )
+{
+  word *t = (word*)must_malloc( (x.n > 0 ? x.n : 1)*sizeof( word ) );
+  char *buf = (char*)must_malloc( 32*x.n + pad + 1 );
+  int n = x.n, len = 0, j;
+
+  memcpy( t, x.d, n*sizeof( word ) );
+  while (n > 0) {
+    word rem = divrem_1( t, t, n, rx->base );
+
+    n = normalize( t, n );
+    for ( j=0 ; j < rx->k ; j++ ) {
+      if (n == 0 && rem == 0)
+        break;
+      buf[len++] = digit_chars[ rem % rx->radix ];
+      rem /= rx->radix;
+    }
+  }
+  while (len < pad)
+    buf[len++] = '0';
+  while (len > 0)
+    *out++ = buf[--len];
+  free( t );
+  free( buf );
+  return out;
+}
+
+static char *radix_rec( radix_t *rx, nat x, int i, int pad, char *out )
+{
+  nat q, r;
+  int len;
+
+  while (i >= 0 && nat_cmp( x, rx->pw[i] ) < 0)
+    i--;
+  if (i < 0 || x.n < RADIX_THRESHOLD)
+    return radix_basecase( rx, x, pad, out );
+  len = rx->k << i;
+  nat_divrem( x, rx->pw[i], &q, &r );
+  out = radix_rec( rx, q, i, pad > len ? pad-len : 0, out );
+  out = radix_rec( rx, r, i-1, len, out );
+  nat_free( q );
+  nat_free( r );
+  return out;
+}
+
+static int radix_pow2( nat x, int bits, char *out )
+{
+  int total = 32*(x.n-1) + 32 - leading_zeros( x.d[x.n-1] );
+  int ndigits = (total + bits - 1) / bits, i;
+
+  for ( i=ndigits-1 ; i >= 0 ; i-- ) {
+    int pos = i*bits, idx = pos / 32, off = pos % 32;
+    word v = x.d[idx] >> off;
+
+    if (off + bits > 32 && idx+1 < x.n)
+      v |= x.d[idx+1] << (32-off);
+    *out++ = digit_chars[ v & ((1 << bits) - 1) ];
+  }
+  return ndigits;
+}
+
+static int nat_to_string( nat x, int radix, char *out )
+{
+  radix_t rx;
+  int i, top, len;
+
+  if (x.n == 0) {
+    *out = '0';
+    return 1;
+  }
+  if ((radix & (radix-1)) == 0)
+    return radix_pow2( x, 31 - leading_zeros( radix ), out );
+
+  rx.radix = radix;
+  rx.k = 1;
+  rx.base = radix;
+  while ((dword)rx.base * radix <= 0xFFFFFFFF) {
+    rx.base *= radix;
+    rx.k++;
+  }
+  rx.pw[0] = nat_alloc( 1 );
+  rx.pw[0].d[0] = rx.base;
+  top = 0;
+  while (top < 31 && 2*rx.pw[top].n <= x.n && x.n >= RADIX_THRESHOLD) {
+    rx.pw[top+1] = nat_mul( rx.pw[top], rx.pw[top] );
+    top++;
+  }
+  len = radix_rec( &rx, x, top, 0, out ) - out;
+  for ( i=0 ; i <= top ; i++ )
+    nat_free( rx.pw[i] );
+  return len;
+}
+
+/* Interface to the bignums. */
+
+static nat nat_of_bignum( word w )
+{
+  return nat_slice( big_digits( w ), bignum_length( w ), 0,
+                    bignum_length( w ) );
+}
+
+/* Stores the magnitude x in bignum w with a positive sign.  Returns 0
+   if it does not fit. */
+
+static int store( word w, word *d, int n )
+{
+  int cap = big_capacity( w );
+
+  n = normalize( d, n );
+  if (n > cap)
+    return 0;
+  if (d != big_digits( w ))
+    memmove( big_digits( w ), d, n*sizeof( word ) );
+  memset( big_digits( w )+n, 0, (cap-n)*sizeof( word ) );
+  *(ptrof( w )+1) = mkbignum_header( 0, n );
+  return 1;
+}
+
+static word big_addsub( int op, word w_a, word w_b, word w_c )
+{
+  word *a = big_digits( w_a ), *b = big_digits( w_b ), *c = big_digits( w_c );
+  int an = bignum_length( w_a ), bn = bignum_length( w_b ), sign = 1;
+
+  if (an < bn || (an == bn && cmp_n( a, b, an ) < 0)) {
+    word *t = a; a = b; b = t;
+    an = bignum_length( w_b );
+    bn = bignum_length( w_a );
+    sign = -1;
+  }
+  if (big_capacity( w_c ) < an + (op == BIG_ADD))
+    return FALSE_CONST;
+  if (op == BIG_ADD) {
+    c[an] = add( c, a, an, b, bn );
+    store( w_c, c, an+1 );
+    return w_c;
+  }
+  sub( c, a, an, b, bn );
+  store( w_c, c, an );
+  return bignum_length( w_c ) == 0 ? fixnum( 0 ) : fixnum( sign );
+}
+
+static word big_mul( word w_a, word w_b, word w_c )
+{
+  int an = bignum_length( w_a ), bn = bignum_length( w_b );
+
+  if (big_capacity( w_c ) < an+bn)
+    return FALSE_CONST;
+  if (an == 0 || bn == 0)
+    store( w_c, big_digits( w_c ), 0 );
+  else {
+    if (an >= bn)
+      mul( big_digits( w_c ), big_digits( w_a ), an, big_digits( w_b ), bn );
+    else
+      mul( big_digits( w_c ), big_digits( w_b ), bn, big_digits( w_a ), an );
+    store( w_c, big_digits( w_c ), an+bn );
+  }
+  return w_c;
+}
+
+/* w_u holds the dividend and receives the remainder. */
+
+static word big_divrem( word w_u, word w_b, word w_q )
+{
+  nat a, b, q, r;
+  int ok;
+
+  if (bignum_length( w_b ) == 0)
+    return FALSE_CONST;
+  a = nat_of_bignum( w_u );
+  b = nat_of_bignum( w_b );
+  nat_divrem( a, b, &q, &r );
+  ok = store( w_q, q.d, q.n ) && store( w_u, r.d, r.n );
+  nat_free( a ); nat_free( b ); nat_free( q ); nat_free( r );
+  return ok ? TRUE_CONST : FALSE_CONST;
+}
+
+/* w_u and w_v are overwritten; w_u receives the gcd. */
+
+static word big_gcd( word w_u, word w_v )
+{
+  nat g = nat_gcd( nat_of_bignum( w_u ), nat_of_bignum( w_v ) );
+  int ok = store( w_u, g.d, g.n );
+
+  nat_free( g );
+  return ok ? w_u : FALSE_CONST;
+}
+
+/* Writes the digits of |a| into the bytevector and returns their number. */
+
+static word big_tostring( word w_a, word w_radix, word w_bv )
+{
+  nat a;
+  char *buf;
+  int radix = (int)nativeint( w_radix ), len;
+  word result = FALSE_CONST;
+
+  if (radix < 2 || radix > 36)
+    return FALSE_CONST;
+  a = nat_of_bignum( w_a );
+  buf = (char*)must_malloc( 32*a.n + 1 );
+  len = nat_to_string( a, radix, buf );
+  if (len <= (int)bytevector_length( w_bv )) {
+    memcpy( (char*)(ptrof( w_bv )+1), buf, len );
+    result = fixnum( len );
+  }
+  free( buf );
+  nat_free( a );
+  return result;
+}
+
+void primitive_bignum_op( word w_op, word w_a, word w_b, word w_c )
+{
+  word result = FALSE_CONST;
+
+  switch (nativeint( w_op )) {
+  case BIG_ADD :
+  case BIG_SUB :
+    result = big_addsub( nativeint( w_op ), w_a, w_b, w_c );
+    break;
+  case BIG_MUL :
+    result = big_mul( w_a, w_b, w_c );
+    break;
+  case BIG_DIVREM :
+    result = big_divrem( w_a, w_b, w_c );
+    break;
+  case BIG_GCD :
+    result = big_gcd( w_a, w_b );
+    break;
+  case BIG_TOSTRING :
+    result = big_tostring( w_a, w_b, w_c );
+    break;
+  }
+  globals[ G_RESULT ] = result;
+}
+
+/* eof */
@@ -0,0 +1,987 @@
+/* Copyright 2026 The Larceny Project.
+ *
+ * $Id$
+ *
+ * Larceny run-time system -- bulk operations on bytevector data.
+ *
+ * These are the kernels behind the homogeneous vectors of SRFI 4
+ * (lib/SRFI/srfi-4.sch), whose elements are stored unboxed in
+ * bytevectors: fill, element-wise arithmetic, dot product, sum,
+ * minimum and maximum.
+ *
+ * The file also holds the byte scanning, UTF-8 transcoding, string
+ * builder appends, and Ascii case-insensitive comparison used by the
+ * string and bytevector libraries (Lib/Common/bytevector.sch, iosys.sch,
+ * stringio.sch, unicode3.sch), and the content digest used by the
+ * compiler's cache of compiled files.
+ *
+ * The loops use SSE2 or AVX/AVX2 when the compiler targets them and
+ * are plain C otherwise.  The Scheme code checks types before calling
+ * in; the kernels only guard against running off the end of their
+ * operands.
+ */
+
+#include <string.h>
+
+#include "larceny.h"
+
+#if defined __SSE2__
+# include <emmintrin.h>
+#endif
+#if defined __AVX__
+# include <immintrin.h>
+#endif
+
+/* Element types and operations; must agree with lib/SRFI/srfi-4.sch. */
+
+#define HV_U8   0
+#define HV_S32  1
+#define HV_F64  2
+
+#define HV_FILL 0
+#define HV_ADD  1
+#define HV_SUB  2
+#define HV_MUL  3
+#define HV_DIV  4
+#define HV_DOT  5
+#define HV_SUM  6
+#define HV_MIN  7
+#define HV_MAX  8
+
+#define bv_data( w )  ((byte*)(ptrof( w )+1))
+#define bv_count( w, size )  (bytevector_length( w ) / (size))
+
+static int min_count( int a, int b ) { return a < b ? a : b; }
+
+/* f64 */
+
+static void f64_fill( double *d, int n, double x )
+{
+  int i;
+
+  for ( i=0 ; i < n ; i++ )
+    d[i] = x;
+}
+
+/* Element-wise d[i] = a[i] op b[i].  The operands may overlap exactly
+   (the destination may be one of the sources). */
+
+#if defined __AVX__
+# define F64_ARITH( name, op, vop )                                     \
+  static void name( double *d, double *a, double *b, int n )            \
+  {                                                                     \
+    int i = 0;                                                          \
+    for ( ; i+4 <= n ; i += 4 )                                         \
+      _mm256_storeu_pd( d+i, vop( _mm256_loadu_pd( a+i ),               \
+                                  _mm256_loadu_pd( b+i ) ) );           \
+    for ( ; i < n ; i++ )                                               \
+      d[i] = a[i] op b[i];                                              \
+  }
+F64_ARITH( f64_add, +, _mm256_add_pd )
+F64_ARITH( f64_sub, -, _mm256_sub_pd )
+F64_ARITH( f64_mul, *, _mm256_mul_pd )
+F64_ARITH( f64_div, /, _mm256_div_pd )
+#elif defined __SSE2__
+# define F64_ARITH( name, op, vop )                                     \
+  static void name( double *d, double *a, double *b, int n )            \
+  {                                                                     \
+    int i = 0;                                                          \
+    for ( ; i+2 <= n ; i += 2 )                                         \
+      _mm_storeu_pd( d+i, vop( _mm_loadu_pd( a+i ), _mm_loadu_pd( b+i ) ) ); \
+    for ( ; i < n ; i++ )                                               \
+      d[i] = a[i] op b[i];                                              \
+  }
+F64_ARITH( f64_add, +, _mm_add_pd )
+F64_ARITH( f64_sub, -, _mm_sub_pd )
+F64_ARITH( f64_mul, *, _mm_mul_pd )
+F64_ARITH( f64_div, /, _mm_div_pd )
+#else
+# define F64_ARITH( name, op, vop )                                     \
+  static void name( double *d, double *a, double *b, int n )            \
+  {                                                                     \
+    int i;                                                              \
+    for ( i=0 ; i < n ; i++ )                                           \
+      d[i] = a[i] op b[i];                                              \
+  }
+F64_ARITH( f64_add, +, _ )
+F64_ARITH( f64_sub, -, _ )
+F64_ARITH( f64_mul, *, _ )
+F64_ARITH( f64_div, /, _ )
+#endif
+
+/* The sum and the dot product are accumulated in several independent
+   partial sums, so they may differ from a left-to-right sum in the
+   last bits. */
+
+static double f64_dot( double *a, double *b, int n )
+{
+  int i = 0;
+  double s = 0.0;
+#if defined __AVX__
+  __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+  double t[4];
+
+  for ( ; i+8 <= n ; i += 8 ) {
+    acc0 = _mm256_add_pd( acc0, _mm256_mul_pd( _mm256_loadu_pd( a+i ),
+                                               _mm256_loadu_pd( b+i ) ) );
+    acc1 = _mm256_add_pd( acc1, _mm256_mul_pd( _mm256_loadu_pd( a+i+4 ),
+                                               _mm256_loadu_pd( b+i+4 ) ) );
+  }
+  _mm256_storeu_pd( t, _mm256_add_pd( acc0, acc1 ) );
+  s = (t[0] + t[1]) + (t[2] + t[3]);
+#elif defined __SSE2__
+  __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+  double t[2];
+
+  for ( ; i+4 <= n ; i += 4 ) {
+    acc0 = _mm_add_pd( acc0, _mm_mul_pd( _mm_loadu_pd( a+i ),
+                                         _mm_loadu_pd( b+i ) ) );
+    acc1 = _mm_add_pd( acc1, _mm_mul_pd( _mm_loadu_pd( a+i+2 ),
+                                         _mm_loadu_pd( b+i+2 ) ) );
+  }
+  _mm_storeu_pd( t, _mm_add_pd( acc0, acc1 ) );
+  s = t[0] + t[1];
+#endif
+  for ( ; i < n ; i++ )
+    s += a[i] * b[i];
+  return s;
+}
+
+static double f64_sum( double *a, int n )
+{
+  int i = 0;
+  double s = 0.0;
+#if defined __AVX__
+  __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+  double t[4];
+
+  for ( ; i+8 <= n ; i += 8 ) {
+    acc0 = _mm256_add_pd( acc0, _mm256_loadu_pd( a+i ) );
+    acc1 = _mm256_add_pd( acc1, _mm256_loadu_pd( a+i+4 ) );
+  }
+  _mm256_storeu_pd( t, _mm256_add_pd( acc0, acc1 ) );
+  s = (t[0] + t[1]) + (t[2] + t[3]);
+#elif defined __SSE2__
+  __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+  double t[2];
+
+  for ( ; i+4 <= n ; i += 4 ) {
+    acc0 = _mm_add_pd( acc0, _mm_loadu_pd( a+i ) );
+    acc1 = _mm_add_pd( acc1, _mm_loadu_pd( a+i+2 ) );
+  }
+  _mm_storeu_pd( t, _mm_add_pd( acc0, acc1 ) );
+  s = t[0] + t[1];
+#endif
+  for ( ; i < n ; i++ )
+    s += a[i];
+  return s;
+}
+
+/* Minimum or maximum of n > 0 elements.  Like flmin and flmax, the
+   result is a NaN if any element is a NaN. */
+
+static double f64_minmax( double *a, int n, int max )
+{
+  int i = 0, nan = 0;
+  double m = a[0];
+#if defined __SSE2__
+  __m128d acc = _mm_set1_pd( m ), nans = _mm_setzero_pd();
+  double t[2];
+
+  for ( ; i+2 <= n ; i += 2 ) {
+    __m128d v = _mm_loadu_pd( a+i );
+    nans = _mm_or_pd( nans, _mm_cmpunord_pd( v, v ) );
+    acc = max ? _mm_max_pd( acc, v ) : _mm_min_pd( acc, v );
+  }
+  nan = _mm_movemask_pd( nans ) != 0;
+  _mm_storeu_pd( t, acc );
+  m = max ? (t[0] > t[1] ? t[0] : t[1]) : (t[0] < t[1] ? t[0] : t[1]);
+#endif
+  for ( ; i < n ; i++ ) {
+    if (a[i] != a[i]) nan = 1;
+    else if (max ? a[i] > m : a[i] < m) m = a[i];
+  }
+  if (nan)
+    for ( i=0 ; i < n ; i++ )
+      if (a[i] != a[i]) return a[i];
+  return m;
+}
+
+/* s32 */
+
+static void s32_fill( int *d, int n, int x )
+{
+  int i;
+
+  for ( i=0 ; i < n ; i++ )
+    d[i] = x;
+}
+
+/* A 16MB bytevector holds at most 2^22 elements, so the sum of 32-bit
+   elements fits comfortably in 64 bits. */
+
+static long long s32_sum( int *a, int n )
+{
+  int i;
+  long long s = 0;
+
+  for ( i=0 ; i < n ; i++ )
+    s += a[i];
+  return s;
+}
+
+static int s32_minmax( int *a, int n, int max )
+{
+  int i = 0, m = a[0];
+#if defined __AVX2__
+  __m256i acc = _mm256_set1_epi32( m );
+  int t[8], j;
+
+  for ( ; i+8 <= n ; i += 8 ) {
+    __m256i v = _mm256_loadu_si256( (__m256i*)(a+i) );
+    acc = max ? _mm256_max_epi32( acc, v ) : _mm256_min_epi32( acc, v );
+  }
+  _mm256_storeu_si256( (__m256i*)t, acc );
+  for ( j=0 ; j < 8 ; j++ )
+    if (max ? t[j] > m : t[j] < m) m = t[j];
+#endif
+  for ( ; i < n ; i++ )
+    if (max ? a[i] > m : a[i] < m) m = a[i];
+  return m;
+}
+
+/* u8 */
+
+static unsigned long u8_sum( byte *a, int n )
+{
+  int i = 0;
+  unsigned long s = 0;
+#if defined __SSE2__
+  __m128i acc = _mm_setzero_si128(), zero = _mm_setzero_si128();
+  unsigned int t[4];
+
+  for ( ; i+16 <= n ; i += 16 )
+    acc = _mm_add_epi64( acc, _mm_sad_epu8( _mm_loadu_si128( (__m128i*)(a+i) ),
+                                            zero ) );
+  _mm_storeu_si128( (__m128i*)t, acc );
+  s = t[0] + t[2];       /* each 64-bit half holds a sum below 2^32 */
+#endif
+  for ( ; i < n ; i++ )
+    s += a[i];
+  return s;
+}
+
+static int u8_minmax( byte *a, int n, int max )
+{
+  int i = 0, m = a[0];
+#if defined __SSE2__
+  __m128i acc = _mm_set1_epi8( (char)m );
+  byte t[16];
+  int j;
+
+  for ( ; i+16 <= n ; i += 16 ) {
+    __m128i v = _mm_loadu_si128( (__m128i*)(a+i) );
+    acc = max ? _mm_max_epu8( acc, v ) : _mm_min_epu8( acc, v );
+  }
+  _mm_storeu_si128( (__m128i*)t, acc );
+  for ( j=0 ; j < 16 ; j++ )
+    if (max ? t[j] > m : t[j] < m) m = t[j];
+#endif
+  for ( ; i < n ; i++ )
+    if (max ? a[i] > m : a[i] < m) m = a[i];
+  return m;
+}
+
+/* The syscall.  w_code is fixnum(op*4 + type).  FILL takes the fill
+   value in w_a; DOT, SUM, MIN and MAX return their result, the others
+   return the destination.  MIN and MAX require a nonempty operand. */
+
+void primitive_hvector_op( word w_code, word w_dst, word w_a, word w_b )
+{
+  int code = nativeint( w_code );
+  int op = code >> 2, type = code & 3;
+  int size = (type == HV_F64 ? 8 : type == HV_S32 ? 4 : 1);
+  int n;
+
+  globals[ G_RESULT ] = w_dst;
+  switch (op) {
+  case HV_FILL :
+    n = bv_count( w_dst, size );
+    if (type == HV_F64)
+      f64_fill( (double*)bv_data( w_dst ), n,
+                real_part( w_a ) );
+    else if (type == HV_S32)
+      s32_fill( (int*)bv_data( w_dst ), n, unbox_int( w_a ) );
+    else
+      memset( bv_data( w_dst ), nativeint( w_a ), n );
+    break;
+  case HV_ADD : case HV_SUB : case HV_MUL : case HV_DIV : {
+    double *d = (double*)bv_data( w_dst );
+    double *a = (double*)bv_data( w_a );
+    double *b = (double*)bv_data( w_b );
+
+    if (type != HV_F64) break;
+    n = min_count( bv_count( w_dst, 8 ),
+                   min_count( bv_count( w_a, 8 ), bv_count( w_b, 8 ) ) );
+    switch (op) {
+    case HV_ADD : f64_add( d, a, b, n ); break;
+    case HV_SUB : f64_sub( d, a, b, n ); break;
+    case HV_MUL : f64_mul( d, a, b, n ); break;
+    case HV_DIV : f64_div( d, a, b, n ); break;
+    }
+    break;
+  }
+  case HV_DOT : {
+    double r;
+
+    if (type != HV_F64) break;
+    n = min_count( bv_count( w_a, 8 ), bv_count( w_b, 8 ) );
+    r = f64_dot( (double*)bv_data( w_a ), (double*)bv_data( w_b ), n );
+    globals[ G_RESULT ] = box_double( r );
+    break;
+  }
+  case HV_SUM :
+    n = bv_count( w_a, size );
+    if (type == HV_F64)
+      globals[ G_RESULT ] = box_double( f64_sum( (double*)bv_data( w_a ), n ) );
+    else if (type == HV_S32)
+      globals[ G_RESULT ] = box_longlong( s32_sum( (int*)bv_data( w_a ), n ) );
+    else
+      globals[ G_RESULT ] = box_uint( u8_sum( bv_data( w_a ), n ) );
+    break;
+  case HV_MIN : case HV_MAX :
+    n = bv_count( w_a, size );
+    if (n == 0)
+      globals[ G_RESULT ] = FALSE_CONST;
+    else if (type == HV_F64)
+      globals[ G_RESULT ] =
+        box_double( f64_minmax( (double*)bv_data( w_a ), n, op == HV_MAX ) );
+    else if (type == HV_S32)
+      globals[ G_RESULT ] =
+        box_int( s32_minmax( (int*)bv_data( w_a ), n, op == HV_MAX ) );
+    else
+      globals[ G_RESULT ] =
+        fixnum( u8_minmax( bv_data( w_a ), n, op == HV_MAX ) );
+    break;
+  default :
+    globals[ G_RESULT ] = FALSE_CONST;
+    break;
+  }
+}
+
+/* Scanning and transcoding.
+
+   Strings are either flat1 (one Latin-1 byte per character) or flat4
+   (one 32-bit character object per character), as determined by the
+   header.  These procedures fail by returning #f, in which case the
+   Scheme code falls back on its own loops; they never signal errors.
+   */
+
+#define is_flat4( s )         ((*ptrof( s ) & 255) == USTR_HDR)
+#define flat4_length( s )     (sizefield( *ptrof( s ) ) / 4)
+#define flat4_data( s )       ((word*)(ptrof( s )+1))
+
+static int any_string_length( word s )
+{
+  return is_flat4( s ) ? flat4_length( s ) : string_length( s );
+}
+
+/* Index of the lowest set bit of m, which is nonzero. */
+
+static int first_bit( unsigned m )
+{
+#if defined __GNUC__
+  return __builtin_ctz( m );
+#else
+  int i = 0;
+
+  while ((m & 1) == 0) {
+    m >>= 1;
+    i++;
+  }
+  return i;
+#endif
+}
+
+/* Checks that w_start and w_end are fixnums with 0 <= start <= end <= n. */
+
+static int get_range( word w_start, word w_end, int n, int *start, int *end )
+{
+  if (!is_fixnum( w_start ) || !is_fixnum( w_end ))
+    return 0;
+  *start = nativeint( w_start );
+  *end = nativeint( w_end );
+  return 0 <= *start && *start <= *end && *end <= n;
+}
+
+/* Number of leading bytes of p[0..n) that are Ascii. */
+
+static int ascii_prefix( byte *p, int n )
+{
+  int i = 0;
+#if defined __SSE2__
+  for ( ; i+16 <= n ; i += 16 ) {
+    int m = _mm_movemask_epi8( _mm_loadu_si128( (__m128i*)(p+i) ) );
+    if (m != 0)
+      return i + first_bit( m );
+  }
+#endif
+  while (i < n && p[i] < 0x80)
+    i++;
+  return i;
+}
+
+/* Stores the n Ascii bytes at s as character objects at d. */
+
+static void widen_ascii( word *d, byte *s, int n )
+{
+  int i = 0;
+#if defined __SSE2__
+  __m128i zero = _mm_setzero_si128(), tag = _mm_set1_epi32( IMM_CHAR );
+
+  for ( ; i+8 <= n ; i += 8 ) {
+    __m128i w = _mm_unpacklo_epi8( _mm_loadl_epi64( (__m128i*)(s+i) ), zero );
+    __m128i lo = _mm_slli_epi32( _mm_unpacklo_epi16( w, zero ), 8 );
+    __m128i hi = _mm_slli_epi32( _mm_unpackhi_epi16( w, zero ), 8 );
+    _mm_storeu_si128( (__m128i*)(d+i), _mm_or_si128( lo, tag ) );
+    _mm_storeu_si128( (__m128i*)(d+i+4), _mm_or_si128( hi, tag ) );
+  }
+#endif
+  for ( ; i < n ; i++ )
+    d[i] = int_to_char( s[i] );
+}
+
+/* Stores the leading Ascii characters of s[0..n) as bytes at d and
+   returns how many there were. */
+
+static int narrow_ascii( byte *d, word *s, int n )
+{
+  int i = 0;
+#if defined __SSE2__
+  __m128i high = _mm_set1_epi32( (int)0xffff8000 ), zero = _mm_setzero_si128();
+
+  for ( ; i+8 <= n ; i += 8 ) {
+    __m128i a = _mm_loadu_si128( (__m128i*)(s+i) );
+    __m128i b = _mm_loadu_si128( (__m128i*)(s+i+4) );
+    __m128i big = _mm_and_si128( _mm_or_si128( a, b ), high );
+    __m128i w;
+
+    if (_mm_movemask_epi8( _mm_cmpeq_epi32( big, zero ) ) != 0xffff)
+      break;
+    w = _mm_packs_epi32( _mm_srli_epi32( a, 8 ), _mm_srli_epi32( b, 8 ) );
+    _mm_storel_epi64( (__m128i*)(d+i), _mm_packus_epi16( w, w ) );
+  }
+#endif
+  for ( ; i < n && charcode( s[i] ) < 0x80 ; i++ )
+    d[i] = charcode( s[i] );
+  return i;
+}
+
+/* Decodes the well-formed UTF-8 sequence that begins at p and ends
+   before end, storing its scalar value in *cp.  Returns the length of
+   the sequence, or 0 if it is ill-formed (Unicode 3.9, table 3-7). */
+
+static int utf8_char( byte *p, byte *end, unsigned *cp )
+{
+  unsigned b = p[0], lo = 0x80, hi = 0xbf;
+  int k, i;
+
+  if (b < 0x80) { *cp = b; return 1; }
+  else if (b < 0xc2) return 0;
+  else if (b < 0xe0) { k = 2; *cp = b & 0x1f; }
+  else if (b < 0xf0) {
+    k = 3; *cp = b & 0x0f;
+    if (b == 0xe0) lo = 0xa0;
+    else if (b == 0xed) hi = 0x9f;
+  }
+  else if (b < 0xf5) {
+    k = 4; *cp = b & 0x07;
+    if (b == 0xf0) lo = 0x90;
+    else if (b == 0xf4) hi = 0x8f;
+  }
+  else return 0;
+
+  if (end - p < k) return 0;
+  for ( i=1 ; i < k ; i++ ) {
+    b = p[i];
+    if (b < lo || b > hi) return 0;
+    *cp = (*cp << 6) | (b & 0x3f);
+    lo = 0x80;
+    hi = 0xbf;
+  }
+  return k;
+}
+
+/* Returns the index of the first byte of bv[start..end) that lies in
+   the range lo..hi, or #f if there is none.  spec is lo + 256*hi,
+   plus 65536 to search instead for the first byte outside the range.
+   A single-byte search is a memchr. */
+
+void primitive_bytevector_scan( word w_bv, word w_spec, word w_start,
+                                word w_end )
+{
+  byte *p = bv_data( w_bv );
+  int spec = nativeint( w_spec );
+  int lo = spec & 255, span = ((spec >> 8) & 255) - lo;
+  int outside = (spec >> 16) & 1;
+  int i, end;
+
+  globals[ G_RESULT ] = FALSE_CONST;
+  if (!get_range( w_start, w_end, bytevector_length( w_bv ), &i, &end ))
+    return;
+
+  if (!outside && span == 0) {
+    byte *q = memchr( p+i, lo, end-i );
+    if (q != 0)
+      globals[ G_RESULT ] = fixnum( q-p );
+    return;
+  }
+#if defined __SSE2__
+  {
+    __m128i vlo = _mm_set1_epi8( (char)lo ), vspan = _mm_set1_epi8( (char)span );
+
+    for ( ; i+16 <= end ; i += 16 ) {
+      __m128i d = _mm_sub_epi8( _mm_loadu_si128( (__m128i*)(p+i) ), vlo );
+      int m = _mm_movemask_epi8( _mm_cmpeq_epi8( _mm_min_epu8( d, vspan ), d ) );
+
+      if (outside)
+        m = ~m & 0xffff;
+      if (m != 0) {
+        globals[ G_RESULT ] = fixnum( i + first_bit( m ) );
+        return;
+      }
+    }
+  }
+#endif
+  for ( ; i < end ; i++ )
+    if (((unsigned)(p[i] - lo) <= (unsigned)span) != outside) {
+      globals[ G_RESULT ] = fixnum( i );
+      return;
+    }
+}
+
+/* With w_s = #f, returns the number of characters encoded by the
+   well-formed UTF-8 in bv[start..end), or #f if it is not well-formed.
+   Otherwise w_s is a string of exactly that length, and the characters
+   are stored into it; returns #t, or #f if a character does not fit in
+   a flat1 string. */
+
+void primitive_utf8_decode( word w_bv, word w_start, word w_end, word w_s )
+{
+  byte *p = bv_data( w_bv ), *end;
+  int start, e, k = 0, limit = 0, flat4 = 0;
+  int store = w_s != FALSE_CONST;
+  unsigned cp;
+
+  globals[ G_RESULT ] = FALSE_CONST;
+  if (!get_range( w_start, w_end, bytevector_length( w_bv ), &start, &e ))
+    return;
+  end = p + e;
+  p += start;
+  if (store) {
+    flat4 = is_flat4( w_s );
+    limit = any_string_length( w_s );
+  }
+
+  while (p < end) {
+    int a = ascii_prefix( p, end-p );
+
+    if (store) {
+      if (k + a > limit)
+        return;
+      if (flat4)
+        widen_ascii( flat4_data( w_s )+k, p, a );
+      else
+        memcpy( string_data( w_s )+k, p, a );
+    }
+    k += a;
+    p += a;
+    if (p < end) {
+      int len = utf8_char( p, end, &cp );
+
+      if (len == 0)
+        return;
+      if (store) {
+        if (k >= limit || (!flat4 && cp > 255))
+          return;
+        if (flat4)
+          flat4_data( w_s )[k] = int_to_char( cp );
+        else
+          string_data( w_s )[k] = (char)cp;
+      }
+      k++;
+      p += len;
+    }
+  }
+
+  if (!store)
+    globals[ G_RESULT ] = fixnum( k );
+  else if (k == limit)
+    globals[ G_RESULT ] = TRUE_CONST;
+}
+
+/* With w_bv = #f, returns the length of the UTF-8 encoding of
+   s[start..end).  Otherwise w_bv is a bytevector of exactly that
+   length, and the encoding is stored into it; returns w_bv. */
+
+void primitive_utf8_encode( word w_s, word w_start, word w_end, word w_bv )
+{
+  int flat4 = is_flat4( w_s );
+  int i, end, k = 0, limit = 0;
+  int store = w_bv != FALSE_CONST;
+  byte *d = store ? bv_data( w_bv ) : 0;
+
+  globals[ G_RESULT ] = FALSE_CONST;
+  if (!get_range( w_start, w_end, any_string_length( w_s ), &i, &end ))
+    return;
+  if (store)
+    limit = bytevector_length( w_bv );
+
+  if (flat4) {
+    word *s = flat4_data( w_s );
+
+    while (i < end) {
+      unsigned cp;
+
+      if (store && limit - k >= end - i) {
+        int a = narrow_ascii( d+k, s+i, end-i );
+        i += a;
+        k += a;
+        if (i == end) break;
+      }
+      cp = charcode( s[i++] );
+      if (cp < 0x80) {
+        if (store) {
+          if (k+1 > limit) return;
+          d[k] = cp;
+        }
+        k += 1;
+      }
+      else if (cp < 0x800) {
+        if (store) {
+          if (k+2 > limit) return;
+          d[k] = 0xc0 | (cp >> 6);
+          d[k+1] = 0x80 | (cp & 0x3f);
+        }
+        k += 2;
+      }
+      else if (cp < 0x10000) {
+        if (store) {
+          if (k+3 > limit) return;
+          d[k] = 0xe0 | (cp >> 12);
+          d[k+1] = 0x80 | ((cp >> 6) & 0x3f);
+          d[k+2] = 0x80 | (cp & 0x3f);
+        }
+        k += 3;
+      }
+      else {
+        if (store) {
+          if (k+4 > limit) return;
+          d[k] = 0xf0 | (cp >> 18);
+          d[k+1] = 0x80 | ((cp >> 12) & 0x3f);
+          d[k+2] = 0x80 | ((cp >> 6) & 0x3f);
+          d[k+3] = 0x80 | (cp & 0x3f);
+        }
+        k += 4;
+      }
+    }
+  }
+  else {
+    byte *s = (byte*)string_data( w_s );
+
+    while (i < end) {
+      int a = ascii_prefix( s+i, end-i );
+
+      if (store) {
+        if (k + a > limit) return;
+        memcpy( d+k, s+i, a );
+      }
+      i += a;
+      k += a;
+      if (i < end) {                    /* Latin-1 above 0x7f */
+        unsigned c = s[i++];
+        if (store) {
+          if (k+2 > limit) return;
+          d[k] = 0xc0 | (c >> 6);
+          d[k+1] = 0x80 | (c & 0x3f);
+        }
+        k += 2;
+      }
+    }
+  }
+
+  if (!store)
+    globals[ G_RESULT ] = fixnum( k );
+  else if (k == limit)
+    globals[ G_RESULT ] = w_bv;
+}
+
+/* Appends src[start..end) to a string builder (Lib/Common/stringio.sch),
+   a record whose fields are a string and the number of characters of
+   it that are in use.  src is a string, copied with memcpy when its
+   representation matches the builder's, or a bytevector holding UTF-8,
+   decoded as it is copied.  Returns #t, or the fixnum length the
+   builder's string must have before the append can succeed, or #f if
+   the arguments are bad, the UTF-8 is ill-formed, or a character does
+   not fit in a flat1 string.  The count is stored only on success. */
+
+#define SB_STRING  1            /* slot 0 holds the record's type */
+#define SB_COUNT   2
+
+void primitive_string_builder_append( word w_sb, word w_src, word w_start,
+                                      word w_end )
+{
+  word w_s = vector_ref( w_sb, SB_STRING ), w_k = vector_ref( w_sb, SB_COUNT );
+  int flat4 = is_flat4( w_s ), limit = any_string_length( w_s );
+  int k, i, end, hdr;
+
+  globals[ G_RESULT ] = FALSE_CONST;
+  if (!is_fixnum( w_k ) || tagof( w_src ) != BVEC_TAG)
+    return;
+  k = nativeint( w_k );
+  hdr = *ptrof( w_src ) & 255;
+
+  if (hdr == BYTEVECTOR_HDR) {
+    byte *p, *q;
+
+    if (!get_range( w_start, w_end, bytevector_length( w_src ), &i, &end ))
+      return;
+    if (k + (end-i) > limit) {          /* never more chars than bytes */
+      globals[ G_RESULT ] = fixnum( k + (end-i) );
+      return;
+    }
+    p = bv_data( w_src ) + i;
+    q = bv_data( w_src ) + end;
+    while (p < q) {
+      int a = ascii_prefix( p, q-p );
+      unsigned cp;
+      int len;
+
+      if (flat4)
+        widen_ascii( flat4_data( w_s )+k, p, a );
+      else
+        memcpy( string_data( w_s )+k, p, a );
+      k += a;
+      p += a;
+      if (p == q)
+        break;
+      len = utf8_char( p, q, &cp );
+      if (len == 0 || (!flat4 && cp > 255))
+        return;
+      if (flat4)
+        flat4_data( w_s )[k] = int_to_char( cp );
+      else
+        string_data( w_s )[k] = (char)cp;
+      k++;
+      p += len;
+    }
+  }
+  else if (hdr == STR_HDR || hdr == USTR_HDR) {
+    int n;
+
+    if (!get_range( w_start, w_end, any_string_length( w_src ), &i, &end ))
+      return;
+    n = end - i;
+    if (k + n > limit) {
+      globals[ G_RESULT ] = fixnum( k + n );
+      return;
+    }
+    if (is_flat4( w_src ) == flat4) {
+      if (flat4)
+        memcpy( flat4_data( w_s )+k, flat4_data( w_src )+i, n*sizeof( word ) );
+      else
+        memcpy( string_data( w_s )+k, string_data( w_src )+i, n );
+      k += n;
+    }
+    else if (flat4) {
+      byte *p = (byte*)string_data( w_src );
+
+      for ( ; i < end ; i++ )
+        flat4_data( w_s )[k++] = int_to_char( p[i] );
+    }
+    else {
+      for ( ; i < end ; i++ ) {
+        unsigned c = charcode( flat4_data( w_src )[i] );
+
+        if (c > 255)
+          return;
+        string_data( w_s )[k++] = (char)c;
+      }
+    }
+  }
+  else
+    return;
+  vector_set( w_sb, SB_COUNT, fixnum( k ) );
+  globals[ G_RESULT ] = TRUE_CONST;
+}
+
+/* Compares s1 and s2 after folding the case of Ascii letters.  Returns
+   -1, 0, or 1 when that settles the order of the case-folded strings,
+   or #f if a non-Ascii character is reached first. */
+
+static int fold_ascii( unsigned c )
+{
+  return (c - 'A' <= 'Z' - 'A') ? c + 32 : c;
+}
+
+void primitive_string_ci_compare( word w_s1, word w_s2 )
+{
+  int flat4 = is_flat4( w_s1 );
+  int n1 = any_string_length( w_s1 ), n2 = any_string_length( w_s2 );
+  int n = n1 < n2 ? n1 : n2;
+  int i = 0;
+
+  globals[ G_RESULT ] = FALSE_CONST;
+  if (is_flat4( w_s2 ) != flat4)
+    return;
+
+  if (flat4) {
+    word *s1 = flat4_data( w_s1 ), *s2 = flat4_data( w_s2 );
+#if defined __SSE2__
+    __m128i high = _mm_set1_epi32( (int)0xffff8000 ), zero = _mm_setzero_si128();
+    __m128i below_a = _mm_set1_epi32( ('A' << 8) - 1 );
+    __m128i above_z = _mm_set1_epi32( ('Z'+1) << 8 );
+    __m128i bit = _mm_set1_epi32( 32 << 8 );
+
+    for ( ; i+4 <= n ; i += 4 ) {
+      __m128i a = _mm_loadu_si128( (__m128i*)(s1+i) );
+      __m128i b = _mm_loadu_si128( (__m128i*)(s2+i) );
+      __m128i big = _mm_and_si128( _mm_or_si128( a, b ), high );
+      __m128i ua = _mm_and_si128( _mm_cmpgt_epi32( a, below_a ),
+                                  _mm_cmpgt_epi32( above_z, a ) );
+      __m128i ub = _mm_and_si128( _mm_cmpgt_epi32( b, below_a ),
+                                  _mm_cmpgt_epi32( above_z, b ) );
+
+      if (_mm_movemask_epi8( _mm_cmpeq_epi32( big, zero ) ) != 0xffff)
+        break;
+      a = _mm_or_si128( a, _mm_and_si128( ua, bit ) );
+      b = _mm_or_si128( b, _mm_and_si128( ub, bit ) );
+      if (_mm_movemask_epi8( _mm_cmpeq_epi32( a, b ) ) != 0xffff)
+        break;
+    }
+#endif
+    for ( ; i < n ; i++ ) {
+      unsigned c1 = charcode( s1[i] ), c2 = charcode( s2[i] );
+
+      if (c1 >= 0x80 || c2 >= 0x80)
+        return;
+      c1 = fold_ascii( c1 );
+      c2 = fold_ascii( c2 );
+      if (c1 != c2) {
+        globals[ G_RESULT ] = fixnum( c1 < c2 ? -1 : 1 );
+        return;
+      }
+    }
+  }
+  else {
+    byte *s1 = (byte*)string_data( w_s1 ), *s2 = (byte*)string_data( w_s2 );
+#if defined __SSE2__
+    __m128i vA = _mm_set1_epi8( 'A' ), v25 = _mm_set1_epi8( 'Z'-'A' );
+    __m128i bit = _mm_set1_epi8( 32 );
+
+    for ( ; i+16 <= n ; i += 16 ) {
+      __m128i a = _mm_loadu_si128( (__m128i*)(s1+i) );
+      __m128i b = _mm_loadu_si128( (__m128i*)(s2+i) );
+      __m128i da = _mm_sub_epi8( a, vA ), db = _mm_sub_epi8( b, vA );
+      __m128i ua = _mm_cmpeq_epi8( _mm_min_epu8( da, v25 ), da );
+      __m128i ub = _mm_cmpeq_epi8( _mm_min_epu8( db, v25 ), db );
+
+      if (_mm_movemask_epi8( _mm_or_si128( a, b ) ) != 0)
+        break;
+      a = _mm_or_si128( a, _mm_and_si128( ua, bit ) );
+      b = _mm_or_si128( b, _mm_and_si128( ub, bit ) );
+      if (_mm_movemask_epi8( _mm_cmpeq_epi8( a, b ) ) != 0xffff)
+        break;
+    }
+#endif
+    for ( ; i < n ; i++ ) {
+      unsigned c1 = s1[i], c2 = s2[i];
+
+      if (c1 >= 0x80 || c2 >= 0x80)
+        return;
+      c1 = fold_ascii( c1 );
+      c2 = fold_ascii( c2 );
+      if (c1 != c2) {
+        globals[ G_RESULT ] = fixnum( c1 < c2 ? -1 : 1 );
+        return;
+      }
+    }
+  }
+
+  globals[ G_RESULT ] = fixnum( n1 < n2 ? -1 : n1 > n2 ? 1 : 0 );
+}
+
+/* Content digest.
+
+   A 128-bit non-cryptographic hash of bv[start..end), stored as 16
+   little-endian bytes into the bytevector w_out.  It is meant for
+   content-addressed caches, where the inputs are not adversarial:
+   two 64-bit lanes absorb eight bytes at a time with a multiply and a
+   rotate, and a final avalanche mixes in the length. */
+
+#define DIGEST_P1  0x9e3779b185ebca87ULL
+#define DIGEST_P2  0xc2b2ae3d27d4eb4fULL
+#define DIGEST_P3  0x165667b19e3779f9ULL
+
+static unsigned long long rotl64( unsigned long long x, int r )
+{
+  return (x << r) | (x >> (64 - r));
+}
+
+static unsigned long long fmix64( unsigned long long k )
+{
+  k ^= k >> 33;
+  k *= 0xff51afd7ed558ccdULL;
+  k ^= k >> 33;
+  k *= 0xc4ceb9fe1a85ec53ULL;
+  k ^= k >> 33;
+  return k;
+}
+
+static unsigned long long load64( byte *p )
+{
+  unsigned long long w = 0;
+  int i;
+
+  for ( i=7 ; i >= 0 ; i-- )
+    w = (w << 8) | p[i];
+  return w;
+}
+
+void primitive_bytevector_digest( word w_bv, word w_start, word w_end,
+                                  word w_out )
+{
+  byte *p = bv_data( w_bv ), *out = bv_data( w_out );
+  unsigned long long h1 = DIGEST_P3, h2 = DIGEST_P1 ^ DIGEST_P2, w;
+  int i, start, end, n;
+
+  globals[ G_RESULT ] = FALSE_CONST;
+  if (!get_range( w_start, w_end, bytevector_length( w_bv ), &start, &end )
+      || bytevector_length( w_out ) < 16)
+    return;
+
+  p += start;
+  n = end - start;
+  for ( i=0 ; i+8 <= n ; i += 8 ) {
+    w = load64( p+i );
+    h1 = rotl64( h1 ^ (w * DIGEST_P2), 31 ) * DIGEST_P1;
+    h2 = (rotl64( h2 ^ (w * DIGEST_P1), 27 ) + h1) * DIGEST_P3;
+  }
+  w = 0;
+  for ( ; i < n ; i++ )
+    w |= (unsigned long long)p[i] << (8 * (i & 7));
+  h1 = rotl64( h1 ^ (w * DIGEST_P2), 31 ) * DIGEST_P1;
+  h2 = (rotl64( h2 ^ (w * DIGEST_P1), 27 ) + h1) * DIGEST_P3;
+
+  h1 ^= (unsigned long long)n;
+  h2 ^= (unsigned long long)n * DIGEST_P2;
+  h1 = fmix64( h1 + h2 );
+  h2 = fmix64( h2 + h1 );
+  for ( i=0 ; i < 8 ; i++ ) {
+    out[i] = (byte)(h1 >> (8*i));
+    out[i+8] = (byte)(h2 >> (8*i));
+  }
+  globals[ G_RESULT ] = w_out;
+}
+
+/* eof */
@@ -60,6 +60,197 @@ typedef union {
 } ffi_arg;
 
 
+/* Convert one actual to its C representation according to the
+ * descriptor value desc (see the table above).  Returns 1 on success;
+ * on failure, prints a message and returns 0.
+ */
+static int
+ffi_convert_arg( word arg, int desc, ffi_arg *out )
+{
+  switch (desc) {
+  case 0 :
+    /* signed32 */
+    switch(tagof(arg)) {
+    case FIX1_TAG :
+    case FIX2_TAG :
+      out->signed32 = nativeint( arg );
+      break;
+    case BVEC_TAG :
+      if (typetag(*ptrof( arg )) == BIG_SUBTAG && bignum_length( arg ) == 1){
+	unsigned w = bignum_ref32( arg, 0 );
+	if (bignum_sign( arg ) == 0 && w < 0x80000000)
+	  out->signed32 = (int)w;
+	else if (bignum_sign( arg ) == 1 && w <= 0x80000000)
+	  out->signed32 = -(int)w;
+	else
+	  goto badarg_s32;
+      }
+      else
+	goto badarg_s32;
+      break;
+    default :
+    badarg_s32:
+      hardconsolemsg( "FFICALL failed: bad arg to signed-word32, val=0x%08x",
+		      arg );
+      return 0;
+    }
+    return 1;
+  case 1 :
+    /* unsigned32 */
+    switch(tagof(arg)) {
+    case FIX1_TAG :
+    case FIX2_TAG :
+      out->unsigned32 = (unsigned)nativeint( arg );
+      break;
+    case BVEC_TAG :
+      if (typetag(*ptrof( arg )) == BIG_SUBTAG
+	  && bignum_length( arg ) == 1
+	  && bignum_sign( arg ) == 0) {
+	out->unsigned32 = bignum_ref32( arg, 0 );
+      }
+      else
+	goto badarg_u32;
+      break;
+    default :
+    badarg_u32:
+      hardconsolemsg( "FFICALL failed: bad arg to unsigned-word32, "
+		      "val=0x%08x", arg );
+      return 0;
+    }
+    return 1;
+  case 2 :
+    /* ieee32 */
+    if (tagof(arg) == BVEC_TAG) {
+      if (typetag(*ptrof(arg)) == FLO_SUBTAG)
+	out->ieee32 = (float)real_part(arg);
+      else if (typetag(*ptrof(arg) == COMP_SUBTAG) && imag_part(arg) == 0.0)
+	out->ieee32 = (float)real_part(arg);
+      else
+	goto badarg_f32;
+    }
+    else {
+    badarg_f32:
+      hardconsolemsg( "FFICALL failed: bad arg to ieee32, val=0x%08x",
+		      arg );
+      return 0;
+    }
+    return 1;
+  case 3 :
+    /* ieee64 */
+    if (tagof(arg) == BVEC_TAG) {
+      if (typetag(*ptrof(arg)) == FLO_SUBTAG)
+	out->ieee64 = real_part(arg);
+      else if (typetag(*ptrof(arg) == COMP_SUBTAG) && imag_part(arg) == 0.0)
+	out->ieee64 = real_part(arg);
+      else
+	goto badarg_f64;
+    }
+    else {
+    badarg_f64:
+      hardconsolemsg( "FFICALL failed: bad arg to ieee64, val=0x%08x",
+		      arg );
+      return 0;
+    }
+    return 1;
+  case 4 :
+    /* pointer */
+    if (arg == 0)
+      out->pointer = (byte*)0;
+    else {
+      switch (tagof( arg )) {
+      case PAIR_TAG :
+	out->pointer = (byte*)ptrof(arg);
+	break;
+      case VEC_TAG :
+      case BVEC_TAG :
+	out->pointer = (byte*)(ptrof(arg)+1);
+	break;
+      default :
+	hardconsolemsg( "FFICALL failed: bad arg to pointer, val=0x%08x",
+		       arg );
+	return 0;
+      }
+    }
+    return 1;
+  case 5 : 
+    /* signed64 */
+    switch(tagof(arg)) {
+    case FIX1_TAG :
+    case FIX2_TAG :
+      out->signed64 = nativeint( arg );
+      break;
+    case BVEC_TAG :
+      if (typetag(*ptrof( arg )) == BIG_SUBTAG && bignum_length( arg ) == 1){
+	unsigned w = bignum_ref32( arg, 0 );
+	if (bignum_sign( arg ) == 0)
+	  out->signed64 = (long long)w;
+	else if (bignum_sign( arg ) == 1)
+	  out->signed64 = -(long long)w;
+	else
+	  goto badarg_s64;
+      }
+      else if (typetag(*ptrof( arg )) == BIG_SUBTAG && 
+	       bignum_length( arg ) == 2){
+	long long val = 0;
+	unsigned w0 = bignum_ref32( arg, 0 );
+	unsigned w1 = bignum_ref32( arg, 1 );
+	val += w0;
+	val += ((long long)w1) << 32;
+	if (bignum_sign( arg ) == 0 && w1 < 0x80000000)
+	  out->signed64 = (long long)val;
+	else if (bignum_sign( arg ) == 1 && w1 <= 0x80000000)
+	  out->signed64 = -(long long)val;
+	else
+	  goto badarg_s64;
+      }
+      else
+	goto badarg_s64;
+      break;
+    default :
+    badarg_s64:
+      hardconsolemsg( "FFICALL failed: bad arg to signed-word64, val=0x%08x",
+		      arg );
+      return 0;
+    }
+    return 1;
+  case 6 : 
+    /* unsigned64 */
+    switch(tagof(arg)) {
+    case FIX1_TAG :
+    case FIX2_TAG :
+      out->unsigned64 = (unsigned)nativeint( arg );
+      break;
+    case BVEC_TAG :
+      if (typetag(*ptrof( arg )) == BIG_SUBTAG
+	  && bignum_length( arg ) == 1
+	  && bignum_sign( arg ) == 0) {
+	out->unsigned64 = bignum_ref32( arg, 0 );
+      }
+      else if (typetag(*ptrof( arg )) == BIG_SUBTAG
+	       && bignum_length( arg ) == 2
+	       && bignum_sign( arg ) == 0) {
+	unsigned long long val = 0;
+	val += bignum_ref32( arg, 0 );
+	val += ((unsigned long long)bignum_ref32( arg, 1 )) << 32;
+	out->unsigned64 = val;
+      }
+      else
+	goto badarg_u64;
+      break;
+    default :
+    badarg_u64:
+      hardconsolemsg( "FFICALL failed: bad arg to unsigned-word64, "
+		      "val=0x%08x", arg );
+      return 0;
+    }
+    return 1;
+  default :
+    hardconsolemsg( "FFICALL failed: bad argdesc value %d", desc );
+    return 0;
+  }
+}
+
+
 void
 larceny_C_ffi_apply( word trampoline_bytevector,
 		     word argument_descriptor,
@@ -97,189 +288,10 @@ larceny_C_ffi_apply( word trampoline_bytevector,
   i = 0;
   limit = bytevector_length( argument_descriptor );
   while (actuals != NIL_CONST && i < limit) {
-    word arg = pair_car( actuals );
-    switch (bytevector_ref( argument_descriptor, i )) {
-    case 0 :
-      /* signed32 */
-      switch(tagof(arg)) {
-      case FIX1_TAG :
-      case FIX2_TAG :
-	args[i].signed32 = nativeint( arg );
-	break;
-      case BVEC_TAG :
-	if (typetag(*ptrof( arg )) == BIG_SUBTAG && bignum_length( arg ) == 1){
-	  unsigned w = bignum_ref32( arg, 0 );
-	  if (bignum_sign( arg ) == 0 && w < 0x80000000)
-	    args[i].signed32 = (int)w;
-	  else if (bignum_sign( arg ) == 1 && w <= 0x80000000)
-	    args[i].signed32 = -(int)w;
-	  else
-	    goto badarg_s32;
-	}
-	else
-	  goto badarg_s32;
-	break;
-      default :
-      badarg_s32:
-	hardconsolemsg( "FFICALL failed: bad arg to signed-word32, val=0x%08x",
-		        arg );
-	goto failed;
-      }
-      break;
-    case 1 :
-      /* unsigned32 */
-      switch(tagof(arg)) {
-      case FIX1_TAG :
-      case FIX2_TAG :
-	args[i].unsigned32 = (unsigned)nativeint( arg );
-	break;
-      case BVEC_TAG :
-	if (typetag(*ptrof( arg )) == BIG_SUBTAG
-	    && bignum_length( arg ) == 1
-	    && bignum_sign( arg ) == 0) {
-	  args[i].unsigned32 = bignum_ref32( arg, 0 );
-	}
-	else
-	  goto badarg_u32;
-	break;
-      default :
-      badarg_u32:
-	hardconsolemsg( "FFICALL failed: bad arg to unsigned-word32, "
-		        "val=0x%08x", arg );
-	goto failed;
-      }
-      break;
-    case 2 :
-      /* ieee32 */
-      if (tagof(arg) == BVEC_TAG) {
-	if (typetag(*ptrof(arg)) == FLO_SUBTAG)
-	  args[i].ieee32 = (float)real_part(arg);
-	else if (typetag(*ptrof(arg) == COMP_SUBTAG) && imag_part(arg) == 0.0)
-	  args[i].ieee32 = (float)real_part(arg);
-	else
-	  goto badarg_f32;
-      }
-      else {
-      badarg_f32:
-	hardconsolemsg( "FFICALL failed: bad arg to ieee32, val=0x%08x",
-		        arg );
-	goto failed;
-      }
-      break;
-    case 3 :
-      /* ieee64 */
-      if (tagof(arg) == BVEC_TAG) {
-	if (typetag(*ptrof(arg)) == FLO_SUBTAG)
-	  args[i].ieee64 = real_part(arg);
-	else if (typetag(*ptrof(arg) == COMP_SUBTAG) && imag_part(arg) == 0.0)
-	  args[i].ieee64 = real_part(arg);
-	else
-	  goto badarg_f64;
-      }
-      else {
-      badarg_f64:
-	hardconsolemsg( "FFICALL failed: bad arg to ieee64, val=0x%08x",
-		        arg );
-	goto failed;
-      }
-      break;
-    case 4 :
-      /* pointer */
-      if (arg == 0)
-	args[i].pointer = (byte*)0;
-      else {
-	switch (tagof( arg )) {
-	case PAIR_TAG :
-	  args[i].pointer = (byte*)ptrof(arg);
-	  break;
-	case VEC_TAG :
-	case BVEC_TAG :
-	  args[i].pointer = (byte*)(ptrof(arg)+1);
-	  break;
-	default :
-	  hardconsolemsg( "FFICALL failed: bad arg to pointer, val=0x%08x",
-			 arg );
-	  goto failed;
-	}
-      }
-      break;
-    case 5 : 
-      /* signed64 */
-      switch(tagof(arg)) {
-      case FIX1_TAG :
-      case FIX2_TAG :
-	args[i].signed64 = nativeint( arg );
-	break;
-      case BVEC_TAG :
-	if (typetag(*ptrof( arg )) == BIG_SUBTAG && bignum_length( arg ) == 1){
-	  unsigned w = bignum_ref32( arg, 0 );
-	  if (bignum_sign( arg ) == 0)
-	    args[i].signed64 = (long long)w;
-	  else if (bignum_sign( arg ) == 1)
-	    args[i].signed64 = -(long long)w;
-	  else
-	    goto badarg_s64;
-	}
-	else if (typetag(*ptrof( arg )) == BIG_SUBTAG && 
-		 bignum_length( arg ) == 2){
-	  long long val = 0;
-	  unsigned w0 = bignum_ref32( arg, 0 );
-	  unsigned w1 = bignum_ref32( arg, 1 );
-	  val += w0;
-	  val += ((long long)w1) << 32;
-	  if (bignum_sign( arg ) == 0 && w1 < 0x80000000)
-	    args[i].signed64 = (long long)val;
-	  else if (bignum_sign( arg ) == 1 && w1 <= 0x80000000)
-	    args[i].signed64 = -(long long)val;
-	  else
-	    goto badarg_s64;
-	}
-	else
-	  goto badarg_s64;
-	break;
-      default :
-      badarg_s64:
-	hardconsolemsg( "FFICALL failed: bad arg to signed-word64, val=0x%08x",
-		        arg );
-	goto failed;
-      }
-      break;
-    case 6 : 
-      /* unsigned64 */
-      switch(tagof(arg)) {
-      case FIX1_TAG :
-      case FIX2_TAG :
-	args[i].unsigned64 = (unsigned)nativeint( arg );
-	break;
-      case BVEC_TAG :
-	if (typetag(*ptrof( arg )) == BIG_SUBTAG
-	    && bignum_length( arg ) == 1
-	    && bignum_sign( arg ) == 0) {
-	  args[i].unsigned64 = bignum_ref32( arg, 0 );
-	}
-	else if (typetag(*ptrof( arg )) == BIG_SUBTAG
-		 && bignum_length( arg ) == 2
-		 && bignum_sign( arg ) == 0) {
-	  unsigned long long val = 0;
-	  val += bignum_ref32( arg, 0 );
-	  val += ((unsigned long long)bignum_ref32( arg, 1 )) << 32;
-	  args[i].unsigned64 = val;
-	}
-	else
-	  goto badarg_u64;
-	break;
-      default :
-      badarg_u64:
-	hardconsolemsg( "FFICALL failed: bad arg to unsigned-word64, "
-			"val=0x%08x", arg );
-      goto failed;
-      }
-      break;
-    default :
-      hardconsolemsg( "FFICALL failed: bad argdesc value %d",
-		      bytevector_ref( argument_descriptor, i ) );
+    if (!ffi_convert_arg( pair_car( actuals ),
+			  bytevector_ref( argument_descriptor, i ),
+			  &args[i] ))
       goto failed;
-    }
     i++;
     actuals = pair_cdr( actuals );
   }
@@ -335,6 +347,208 @@ larceny_C_ffi_apply( word trampoline_bytevector,
 }
 
 
+/* Call stubs.
+ *
+ * larceny_C_ffi_apply() interprets the argument descriptor on every call
+ * and goes through a generated trampoline.  For the common signatures --
+ * up to four word-sized arguments, or up to three ieee64 arguments, or
+ * one of each, returning int, unsigned, double, or void -- we can instead
+ * call the function directly from C through a pointer of the right type.
+ *
+ * A stub is a bytevector of at least 8+argc bytes, allocated by Scheme
+ * once per foreign procedure and filled in by larceny_C_ffi_init_stub():
+ *
+ *     offset  contents
+ *     ------  --------
+ *          0  stub kind (see below)
+ *          4  the address of the C function
+ *          8  the argument descriptor values, one byte per argument
+ *
+ * The stub kind encodes the arity in bits 0-2, the return class in bits
+ * 3-4 (0=int, 1=unsigned, 2=double, 3=void), and in bits 5-8 a mask of
+ * the arguments that are ieee64.  The stub is only valid for the C
+ * calling convention the RTS itself was compiled with (cdecl).
+ */
+
+#define STUB_ARITY( k )     ((k) & 7)
+#define STUB_RET( k )       (((k) >> 3) & 3)
+#define STUB_DMASK( k )     ((k) >> 5)
+#define STUB_SHAPE( k )     ((k) & ~(3 << 3))
+#define STUB_KIND( n, r, m ) ((n) | ((r) << 3) | ((m) << 5))
+
+#define STUB_W0    STUB_KIND( 0, 0, 0 )
+#define STUB_W1    STUB_KIND( 1, 0, 0 )
+#define STUB_W2    STUB_KIND( 2, 0, 0 )
+#define STUB_W3    STUB_KIND( 3, 0, 0 )
+#define STUB_W4    STUB_KIND( 4, 0, 0 )
+#define STUB_D1    STUB_KIND( 1, 0, 1 )
+#define STUB_D2    STUB_KIND( 2, 0, 3 )
+#define STUB_D3    STUB_KIND( 3, 0, 7 )
+#define STUB_DW    STUB_KIND( 2, 0, 1 )
+#define STUB_WD    STUB_KIND( 2, 0, 2 )
+
+/* This is a syscall.
+ *
+ * Fill in the stub bytevector w_stub for a function at w_addr with the
+ * given argument and return descriptors.  Returns #t if there is a
+ * specialized stub for the signature, otherwise #f, in which case the
+ * caller must use larceny_C_ffi_apply().
+ */
+void
+larceny_C_ffi_init_stub( word w_stub, word w_argdesc, word w_retdesc,
+			 word w_addr )
+{
+  int i, argc, ret, dmask;
+  word *stub;
+  byte *desc;
+
+  globals[ G_RESULT ] = FALSE_CONST;
+
+  argc = bytevector_length( w_argdesc );
+  if (argc > 4 || bytevector_length( w_stub ) < 2*sizeof(word) + argc)
+    return;
+
+  switch (nativeint( w_retdesc )) {
+  case 0 : ret = 0; break;	/* int */
+  case 1 : ret = 1; break;	/* unsigned */
+  case 2 : ret = 2; break;	/* double */
+  case 4 : ret = 3; break;	/* void */
+  default : return;
+  }
+
+  dmask = 0;
+  for ( i=0 ; i < argc ; i++ ) {
+    switch (bytevector_ref( w_argdesc, i )) {
+    case 0 :			/* signed32 */
+    case 1 :			/* unsigned32 */
+    case 4 :			/* pointer */
+      break;
+    case 3 :			/* ieee64 */
+      dmask |= 1 << i;
+      break;
+    default :
+      return;
+    }
+  }
+
+  switch (STUB_KIND( argc, 0, dmask )) {
+  case STUB_W0 : case STUB_W1 : case STUB_W2 : case STUB_W3 : case STUB_W4 :
+  case STUB_D1 : case STUB_D2 : case STUB_D3 : case STUB_DW : case STUB_WD :
+    break;
+  default :
+    return;
+  }
+
+  stub = ptrof( w_stub )+1;
+  desc = (byte*)(stub+2);
+  stub[0] = STUB_KIND( argc, ret, dmask );
+  stub[1] = (word)unbox_uint( w_addr );
+  for ( i=0 ; i < argc ; i++ )
+    desc[i] = bytevector_ref( w_argdesc, i );
+  globals[ G_RESULT ] = TRUE_CONST;
+}
+
+/* Invoke the function; params is the parenthesized C parameter type list
+ * and actuals the parenthesized argument list.
+ */
+#define STUB_CALL( params, actuals )					\
+  switch (STUB_RET( kind )) {						\
+  case 0 :								\
+    globals[ G_RESULT ] = box_int( ((int (*)params)fn) actuals );	\
+    return;								\
+  case 1 :								\
+    globals[ G_RESULT ] = box_uint( ((unsigned (*)params)fn) actuals );	\
+    return;								\
+  case 2 :								\
+    globals[ G_RESULT ] = box_double( ((double (*)params)fn) actuals );	\
+    return;								\
+  default :								\
+    ((void (*)params)fn) actuals;					\
+    globals[ G_RESULT ] = UNSPECIFIED_CONST;				\
+    return;								\
+  }
+
+/* This is a syscall, so the value is returned in RESULT.
+ *
+ * w_stub is a stub initialized by larceny_C_ffi_init_stub() and actuals
+ * is a list of actual arguments, of the length given by the stub.
+ * Fixnums, flonums, and vector-like and bytevector-like pointers are
+ * converted inline; anything else goes through ffi_convert_arg().
+ * Returns UNDEFINED_CONST on a conversion error, like larceny_C_ffi_apply.
+ */
+void
+larceny_C_ffi_call_stub( word w_stub, word actuals )
+{
+  word *stub = ptrof( w_stub )+1;
+  word kind = stub[0];
+  void *fn = (void*)stub[1];
+  byte *desc = (byte*)(stub+2);
+  int i, argc = STUB_ARITY( kind );
+  ffi_arg a[ 4 ];
+
+  for ( i=0 ; i < argc ; i++ ) {
+    word arg;
+
+    if (actuals == NIL_CONST)
+      goto wrong_args;
+    arg = pair_car( actuals );
+    actuals = pair_cdr( actuals );
+    switch (desc[i]) {
+    case 0 :
+    case 1 :
+      if (is_fixnum( arg )) {
+	a[i].signed32 = nativeint( arg );
+	continue;
+      }
+      break;
+    case 3 :
+      if (tagof( arg ) == BVEC_TAG && typetag(*ptrof( arg )) == FLO_SUBTAG) {
+	a[i].ieee64 = real_part( arg );
+	continue;
+      }
+      break;
+    case 4 :
+      if (tagof( arg ) == BVEC_TAG || tagof( arg ) == VEC_TAG) {
+	a[i].pointer = (byte*)(ptrof( arg )+1);
+	continue;
+      }
+      break;
+    }
+    if (!ffi_convert_arg( arg, desc[i], &a[i] ))
+      goto failed;
+  }
+  if (actuals != NIL_CONST)
+    goto wrong_args;
+
+  switch (STUB_SHAPE( kind )) {
+  case STUB_W0 : STUB_CALL( (void), () );
+  case STUB_W1 : STUB_CALL( (word), (a[0].unsigned32) );
+  case STUB_W2 : STUB_CALL( (word, word),
+			    (a[0].unsigned32, a[1].unsigned32) );
+  case STUB_W3 : STUB_CALL( (word, word, word),
+			    (a[0].unsigned32, a[1].unsigned32,
+			     a[2].unsigned32) );
+  case STUB_W4 : STUB_CALL( (word, word, word, word),
+			    (a[0].unsigned32, a[1].unsigned32,
+			     a[2].unsigned32, a[3].unsigned32) );
+  case STUB_D1 : STUB_CALL( (double), (a[0].ieee64) );
+  case STUB_D2 : STUB_CALL( (double, double), (a[0].ieee64, a[1].ieee64) );
+  case STUB_D3 : STUB_CALL( (double, double, double),
+			    (a[0].ieee64, a[1].ieee64, a[2].ieee64) );
+  case STUB_DW : STUB_CALL( (double, word), (a[0].ieee64, a[1].unsigned32) );
+  case STUB_WD : STUB_CALL( (word, double), (a[0].unsigned32, a[1].ieee64) );
+  default :
+    hardconsolemsg( "FFICALL failed: bad stub kind %d", kind );
+    goto failed;
+  }
+
+ wrong_args:
+  hardconsolemsg( "FFICALL failed: wrong number of arguments." );
+ failed:
+  globals[ G_RESULT ] = UNDEFINED_CONST;
+}
+
+
 /* This is a syscall.
  *
  * w_path is a pointer to a bytevector containing a string.
@@ -20,6 +20,8 @@
 #include "semispace_t.h"
 #include "heapio.h"
 #include "memmgr.h"
+#include "gclib.h"
+#include "los_t.h"
 
 static gc_t *gc;
 static int  generations;
@@ -85,6 +87,65 @@ word allocate_nonmoving( int length, int tag )
   return 0;
 }
 
+/* A pinned bytevector is allocated in the large-object space, whose
+   objects are never moved, and is padded to more than a page if that
+   is necessary to get it there.  Its data are zeroed.  Returns #f if
+   the object could not be allocated as a large object.
+   */
+word allocate_pinned_bytevector( int length )
+{
+  word *obj;
+
+  if (length < 0 || length > LARGEST_OBJECT - 2*sizeof(word))
+    return FALSE_CONST;
+#if defined(BDW_GC)
+  /* The conservative collector never moves anything. */
+  obj = gc_allocate( gc, length + sizeof(word), 0, 1 );
+#else
+  {
+    int bytes =
+      max( length + sizeof(word), GC_LARGE_OBJECT_LIMIT + 2*sizeof(word) );
+
+    obj = gc_allocate( gc, bytes, 0, 1 );
+    obj[0] = mkheader( bytes - sizeof(word), BYTEVECTOR_HDR );
+    if (!(attr_of( obj ) & MB_LARGE_OBJECT))
+      return FALSE_CONST;
+    gclib_add_pinned( obj, bytes );
+  }
+#endif
+  obj[0] = mkheader( length, BYTEVECTOR_HDR );
+  memset( obj+1, 0, length );
+  return tagptr( obj, BVEC_TAG );
+}
+
+/* A mapped bytevector occupies a page-aligned block of `bytes' bytes
+   that the caller has mapped outside the heap; the block becomes a
+   large object of the youngest generation whose header is at the
+   returned address, and it is unmapped when the object dies.  The
+   caller fills in the header.  Returns 0 if the collector cannot
+   manage such blocks.
+   */
+word *allocate_mapped_block( void *block, int bytes )
+{
+#if defined(BDW_GC) || GCLIB_LARGE_TABLE
+  return 0;
+#else
+  if (gc->los == 0)
+    return 0;
+  return los_add_mapped( gc->los, (word*)block, bytes, 0 );
+#endif
+}
+
+/* True if the object is in memory that the collector will not move. */
+int is_pinned_object( word obj )
+{
+#if defined(BDW_GC)
+  return isptr( obj );
+#else
+  return isptr( obj ) && (attr_of( ptrof( obj ) ) & MB_LARGE_OBJECT);
+#endif
+}
+
 static char *heapio_msg[] =
 { "OK", "Wrong type", "Wrong version", "Can't read", "Can't open",
   "Heap not open", "Can't write", "Unmatched heap code", "Can't close" };
@@ -90,6 +90,8 @@
 # define MB_FLONUMS        128    /* Memory is part of a flonum space */
 # define MB_SUMMARY_SETS   256    /* Memory belongs to summarization sets */
 # define MB_SMIRCY_MARK    512     /* Memory belongs to marking state */
+# define MB_MAPPED_FILE    1024   /* Large object mapped outside the heap */
+# define MB_PINNED         2048   /* Large-object pages of a pinned object */
 #endif
 
 /* The following values are used in the desc_g array for 
@@ -169,6 +171,27 @@ void gclib_add_attribute( void *address, int nbytes, unsigned attr );
      pages in the range implied by `address' and `nbytes'.
      */
 
+void gclib_add_pinned( void *address, int nbytes );
+  /* Mark the pages in the range implied by `address' and `nbytes',
+     which must belong to a large object, as holding a pinned object,
+     and account for them as pinned memory until they are freed.
+     A no-op if GCLIB_LARGE_TABLE is set.
+     */
+
+#if !GCLIB_LARGE_TABLE
+void gclib_add_mapped( void *addr, int bytes, int gen_no );
+  /* Enter the page-aligned block [addr, addr+bytes), which the caller
+     has mapped outside the allocator, in the descriptor tables as a
+     large object of generation `gen_no' whose pages are MB_MAPPED_FILE.
+     The block is not charged to the heap.
+     */
+
+void gclib_free_mapped( void *addr, int bytes );
+  /* Unmap a block entered with gclib_add_mapped() and remove it from
+     the descriptor tables.
+     */
+#endif
+
 void gclib_stats( gclib_stats_t *stats );
   /* Returns some statistics about the memory manager.
      */
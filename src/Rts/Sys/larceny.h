@@ -117,6 +117,9 @@ extern int dump_dumped_heap( char *filename, gc_t *gc, word *globals );
 extern int  create_memory_manager( gc_param_t *params, int *generations );
 extern word *alloc_from_heap( int nbytes );
 extern word allocate_nonmoving( int length, int tag );
+extern word allocate_pinned_bytevector( int length );
+extern word *allocate_mapped_block( void *block, int bytes );
+extern int is_pinned_object( word obj );
 extern int  load_heap_image_from_file( const char *filename );
 extern int  dump_heap_image_to_file( const char *filename );
 extern int  reorganize_and_dump_static_heap( const char *filename );
@@ -174,6 +177,8 @@ extern void primitive_gcctl_np( word, word, word );
 extern void primitive_block_signals( word );
 extern void primitive_allocate_nonmoving( word, word );
 extern void primitive_object_to_address( word );
+extern void primitive_make_pinned_bytevector( word );
+extern void primitive_pinnedp( word );
 extern void primitive_sysfeature( word v );
 extern void primitive_sro( word ptrtag, word hdrtag, word limit );
 extern void primitive_exit( word );
@@ -183,6 +188,40 @@ extern void primitive_time( word );
 #endif
 
 
+/* In Rts/Sys/bulk.c, called only as syscalls */
+extern void primitive_hvector_op( word w_code, word w_dst, word w_a, word w_b );
+extern void primitive_bytevector_scan( word w_bv, word w_spec, word w_start,
+				       word w_end );
+extern void primitive_utf8_decode( word w_bv, word w_start, word w_end,
+				   word w_s );
+extern void primitive_utf8_encode( word w_s, word w_start, word w_end,
+				   word w_bv );
+extern void primitive_string_ci_compare( word w_s1, word w_s2 );
+extern void primitive_bytevector_digest( word w_bv, word w_start, word w_end,
+                                         word w_out );
+extern void primitive_string_builder_append( word w_sb, word w_src,
+                                             word w_start, word w_end );
+
+
+/* In Rts/Sys/bignum.c, called only as a syscall */
+extern void primitive_bignum_op( word w_op, word w_a, word w_b, word w_c );
+
+
+/* In Rts/Sys/flonum.c, called only as a syscall */
+extern void primitive_flonum_op( word w_op, word w_a, word w_b, word w_c );
+
+
+/* In Rts/Sys/oblist.c, called only as a syscall */
+extern void primitive_oblist_lookup( word w_table, word w_s, word w_start,
+                                     word w_end );
+
+
+/* In Rts/Sys/sampler.c */
+extern void sampler_poll( word *globals );
+extern void sampler_enumerate_roots( void (*f)( word*, void* ), void *data );
+extern void primitive_sampler( word w_op, word w_a, word w_b, word w_c );
+
+
 /* In Rts/Sys/sro.c */
 extern word sro( gc_t *gc, int p_tag, int h_tag, int limit );
 
@@ -234,6 +273,9 @@ void larceny_C_ffi_apply( word trampoline_bytevector,
 			  word argument_descriptor,
 			  word return_descriptor,
 		          word actuals );
+void larceny_C_ffi_init_stub( word w_stub, word w_argdesc, word w_retdesc,
+			      word w_addr );
+void larceny_C_ffi_call_stub( word w_stub, word actuals );
 void larceny_C_ffi_dlopen( word w_path );
 void larceny_C_ffi_dlsym( word w_handle, word w_sym );
 void larceny_C_ffi_getaddr( word w_key );
@@ -16,12 +16,13 @@
 #include "gclib.h"
 
 #define HEADER_WORDS     4	/* Number of header words */
-#define HEADER_UNUSED    -4     /* Unused field (could be mark?) */
+#define HEADER_MAPPED    -4     /* Size of a mapped block, or 0 */
 #define HEADER_SIZE      -3     /* Offset of size field */
 #define HEADER_NEXTP     -2	/* Offset of 'next' pointer */
 #define HEADER_PREVP     -1	/* Offset of 'previous' pointer */
 
 #define size( x )         (((int*)(x))[ HEADER_SIZE ])
+#define mapped_size( x )  (((int*)(x))[ HEADER_MAPPED ])
 #define next( x )         (((word**)(x))[ HEADER_NEXTP ])
 #define prev( x )         (((word**)(x))[ HEADER_PREVP ])
 
@@ -160,6 +161,7 @@ word *los_allocate( los_t *los, int nbytes, int gen_no )
 
   w += HEADER_WORDS;
   set_size( w, size );
+  mapped_size( w ) = 0;
   insert_at_end( w, los->object_lists[ gen_no ] );
 
   supremely_annoyingmsg( "{LOS} Allocating large object size %d at 0x%08x", 
@@ -168,6 +170,30 @@ word *los_allocate( los_t *los, int nbytes, int gen_no )
   return w;
 }
 
+#if !GCLIB_LARGE_TABLE
+/* Only the first page of a mapped block is counted as the size of the
+   object, since only that page is heap memory.
+   */
+word *los_add_mapped( los_t *los, word *block, int nbytes, int gen_no )
+{
+  word *w;
+
+  assert( 0 <= gen_no && gen_no < los->generations && nbytes > PAGESIZE );
+
+  gclib_add_mapped( block, nbytes, gen_no );
+
+  w = block + HEADER_WORDS;
+  set_size( w, PAGESIZE );
+  mapped_size( w ) = nbytes;
+  insert_at_end( w, los->object_lists[ gen_no ] );
+
+  supremely_annoyingmsg( "{LOS} Adding mapped object size %d at 0x%08x",
+			 nbytes, w );
+
+  return w;
+}
+#endif
+
 bool los_mark( los_t *los, los_list_t *marked, word *w, int gen_no )
 {
   word *p = prev( w );
@@ -219,7 +245,12 @@ void los_sweep( los_t *los, int gen_no )
     n = next( p );
     remove( p );
     nbytes = size( p );
-    gclib_free( p - HEADER_WORDS, nbytes );
+#if !GCLIB_LARGE_TABLE
+    if (mapped_size( p ) != 0)
+      gclib_free_mapped( p - HEADER_WORDS, mapped_size( p ) );
+    else
+#endif
+      gclib_free( p - HEADER_WORDS, nbytes );
     supremely_annoyingmsg( "{LOS} Freeing large object %d bytes at 0x%08x",
 			   nbytes, (void*)p );
     p = n;
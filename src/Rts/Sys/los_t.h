@@ -91,6 +91,19 @@ word *los_allocate( los_t *los, int nbytes, int gen_no );
      0 <= gen_no < los.generations
      */
 
+#if !GCLIB_LARGE_TABLE
+word *los_add_mapped( los_t *los, word *block, int nbytes, int gen_no );
+  /* Enter the page-aligned block of nbytes at `block', which the caller
+     has mapped outside the heap, in the large object space with the
+     given generation, and return a pointer to the place for the object
+     header.  The block is unmapped when the object dies; only its first
+     page is counted as allocated.
+
+     nbytes > PAGESIZE
+     0 <= gen_no < los.generations
+     */
+#endif
+
 bool los_mark( los_t *los, los_list_t *marked, word *w, int gen_no );
   /* Mark the block by moving it to the end of the 'marked' list, which
      should be a mark list, if it is not already on a mark list.  Returns
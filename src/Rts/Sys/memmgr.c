@@ -2593,6 +2593,7 @@ enumerate_roots( gc_t *gc, void (*f)(word *addr, void *scan_data), void *scan_da
   for ( i = 0 ; i < data->nhandles ; i++ )
     if (data->handles[i] != 0)
       f( &data->handles[i], scan_data );
+  sampler_enumerate_roots( f, scan_data );
 }
 
 /* WARNING: this only enumerates elements of the remsets tracking
@@ -308,7 +308,6 @@ static void stack_underflow( young_heap_t *heap )
 {
   word *globals = DATA(heap)->globals;
 
-  globals[ G_STKUFLOW] += 1;
   if (!stk_restore_frame( globals ))
     stack_overflow( heap );                        /* [sic] */
 }
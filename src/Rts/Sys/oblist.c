@@ -0,0 +1,147 @@
+/* Copyright 2026 The Larceny Project.
+ *
+ * $Id$
+ *
+ * Larceny run-time system -- symbol table lookup.
+ *
+ * The symbol table (Lib/Common/oblist.sch) is a vector whose length is
+ * a power of two, searched by linear probing from a hash of the name.
+ * Each element is #f or an interned symbol, and at most half of them
+ * are symbols.  The table is an ordinary heap object that is only ever
+ * changed by Scheme code; this file only reads it, so it needs no write
+ * barrier and cannot be upset by a garbage collection.
+ *
+ * The name looked up is a range of a string, flat1 or flat4, or of a
+ * bytevector whose bytes are Latin-1 characters (as when the reader
+ * interns a token straight from a port's buffer).  Names are compared
+ * first by length and then with memcmp when the representations agree,
+ * which is the common case.
+ */
+
+#include <string.h>
+
+#include "larceny.h"
+
+#define is_flat4( s )     ((*ptrof( s ) & 255) == USTR_HDR)
+#define is_bytes( s )     ((*ptrof( s ) & 255) == BYTEVECTOR_HDR)
+#define flat4_length( s ) (sizefield( *ptrof( s ) ) / 4)
+#define flat4_data( s )   ((word*)(ptrof( s )+1))
+
+/* A name: either n bytes or n flat4 characters. */
+
+typedef struct {
+  byte *bytes;
+  word *chars;
+  int n;
+} name_t;
+
+static int get_name( word w_s, word w_start, word w_end, name_t *name )
+{
+  int start, end, len, hdr;
+
+  if (!is_fixnum( w_start ) || !is_fixnum( w_end ) || !isptr( w_s )
+      || tagof( w_s ) != BVEC_TAG)
+    return 0;
+  hdr = *ptrof( w_s ) & 255;
+  if (hdr != STR_HDR && hdr != USTR_HDR && hdr != BYTEVECTOR_HDR)
+    return 0;
+  start = nativeint( w_start );
+  end = nativeint( w_end );
+  if (is_flat4( w_s )) {
+    len = flat4_length( w_s );
+    name->bytes = 0;
+    name->chars = flat4_data( w_s ) + start;
+  }
+  else {
+    len = is_bytes( w_s ) ? bytevector_length( w_s ) : string_length( w_s );
+    name->bytes = (byte*)string_data( w_s ) + start;
+    name->chars = 0;
+  }
+  name->n = end - start;
+  return 0 <= start && start <= end && end <= len;
+}
+
+static unsigned name_char( name_t *name, int i )
+{
+  return name->bytes ? name->bytes[i] : charcode( name->chars[i] );
+}
+
+/* FNV-1a over the character codes, then a finalizer so that the low
+   bits, which select the slot, depend on every character.  The hash
+   depends only on the characters, not on the representation. */
+
+static unsigned name_hash( name_t *name )
+{
+  unsigned h = 2166136261u ^ (unsigned)name->n;
+  int i;
+
+  if (name->bytes)
+    for ( i=0 ; i < name->n ; i++ )
+      h = (h ^ name->bytes[i]) * 16777619u;
+  else
+    for ( i=0 ; i < name->n ; i++ )
+      h = (h ^ charcode( name->chars[i] )) * 16777619u;
+  h ^= h >> 16;
+  h *= 0x85ebca6bu;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35u;
+  h ^= h >> 16;
+  return h;
+}
+
+static int same_name( name_t *a, name_t *b )
+{
+  int i;
+
+  if (a->n != b->n)
+    return 0;
+  if (a->bytes && b->bytes)
+    return memcmp( a->bytes, b->bytes, a->n ) == 0;
+  if (a->chars && b->chars)
+    return memcmp( a->chars, b->chars, a->n * sizeof( word ) ) == 0;
+  for ( i=0 ; i < a->n ; i++ )
+    if (name_char( a, i ) != name_char( b, i ))
+      return 0;
+  return 1;
+}
+
+/* Looks up the name s[start..end) in the table.  Returns the symbol if
+   it is there, and otherwise the fixnum index of the empty slot where
+   it should be installed.  Returns #f if the arguments are not as
+   described above or the table has no empty slot. */
+
+void primitive_oblist_lookup( word w_table, word w_s, word w_start,
+                              word w_end )
+{
+  name_t name, other;
+  int n, i, k;
+  word sym, pname;
+
+  globals[ G_RESULT ] = FALSE_CONST;
+  if (tagof( w_table ) != VEC_TAG
+      || !get_name( w_s, w_start, w_end, &name ))
+    return;
+  n = vector_length( w_table );
+  if (n == 0 || (n & (n-1)) != 0)
+    return;
+
+  i = name_hash( &name ) & (n-1);
+  for ( k=0 ; k < n ; k++, i = (i+1) & (n-1) ) {
+    sym = vector_ref( w_table, i );
+    if (sym == FALSE_CONST) {
+      globals[ G_RESULT ] = fixnum( i );
+      return;
+    }
+    pname = vector_ref( sym, 0 );
+    if (get_name( pname, fixnum( 0 ),
+                  fixnum( is_flat4( pname ) ? flat4_length( pname )
+                                            : string_length( pname ) ),
+                  &other )
+        && same_name( &name, &other )) {
+      globals[ G_RESULT ] = sym;
+      return;
+    }
+  }
+}
+
+/* eof */
@@ -71,6 +71,12 @@ void osdep_cwd( void )
   globals[G_RESULT] = FALSE_CONST;
 }
 
+/* Standard C has no process identifiers */
+void osdep_getpid( void )
+{
+  globals[G_RESULT] = fixnum(0);
+}
+
 /* returns #f */
 
 void osdep_listdir_open( word w_path )
@@ -417,6 +423,93 @@ void osdep_writefile( word w_fd, word w_buf, word w_cnt, word w_offset )
   fflush(fp); /* Larceny does its own buffering. */
 }
 
+/* No gathering write in Standard C: the chunks are written one after
+   another, stopping at the first short write.
+   */
+
+void osdep_writevfile( word w_fd, word w_chunks, word w_start, word w_n )
+{
+  int fd = nativeint( w_fd );
+  int i, k, n = nativeint( w_n );
+  FILE *fp;
+  size_t nbytes, res, total;
+
+#ifdef USE_STDIO
+  check_standard_filedes();
+#endif
+
+  assert( fd >= 0 && fd < num_fds );
+
+  if (fdarray[fd].fp == 0) {
+    globals[ G_RESULT ] = fixnum(-1);
+    return;
+  }
+  fp = fdarray[fd].fp;
+  total = 0;
+  for ( i=0, k=3*nativeint( w_start ) ; i < n ; i++, k+=3 ) {
+    nbytes = nativeint( vector_ref( w_chunks, k+2 ) );
+    res = fwrite( string_data( vector_ref( w_chunks, k ) )
+                    + nativeint( vector_ref( w_chunks, k+1 ) ),
+                  1, nbytes, fp );
+    total += res;
+    if (res < nbytes) break;
+  }
+  if (total == 0 && ferror(fp))
+    globals[G_RESULT] = fixnum(-1);
+  else
+    globals[G_RESULT] = fixnum(total);
+  fflush(fp); /* Larceny does its own buffering. */
+}
+
+/* Standard C has no way to copy between streams other than reading
+   and writing, so that is done through a C buffer. */
+
+#define OSDEP_COPY_BUFSIZ  65536
+
+void osdep_copyfd( word w_from, word w_to, word w_cnt )
+{
+  static char *buf = 0;
+  int from = nativeint( w_from );
+  int to = nativeint( w_to );
+  size_t cnt = nativeint( w_cnt );
+  size_t res;
+
+#ifdef USE_STDIO
+  check_standard_filedes();
+#endif
+
+  assert( from >= 0 && from < num_fds );
+  assert( to >= 0 && to < num_fds );
+
+  if (fdarray[from].fp == 0 || fdarray[to].fp == 0) {
+    globals[ G_RESULT ] = fixnum(-1);
+    return;
+  }
+  if (buf == 0 && (buf = (char*)malloc( OSDEP_COPY_BUFSIZ )) == 0) {
+    globals[ G_RESULT ] = fixnum(-1);
+    return;
+  }
+  res = fread( buf, 1, min( cnt, OSDEP_COPY_BUFSIZ ), fdarray[from].fp );
+  if (res == 0 && ferror(fdarray[from].fp))
+    globals[G_RESULT] = fixnum(-1);
+  else if (fwrite( buf, 1, res, fdarray[to].fp ) < res)
+    globals[G_RESULT] = fixnum(-1);
+  else
+    globals[G_RESULT] = fixnum(res);
+  fflush(fdarray[to].fp); /* Larceny does its own buffering. */
+}
+
+/* Standard C cannot map files. */
+
+void osdep_mmapfile( word w_fd, word w_offset, word w_length, word w_shared )
+{
+  globals[ G_RESULT ] = FALSE_CONST;
+}
+
+void osdep_unmapfile( void *addr, int bytes )
+{
+}
+
 /* FIXME: limits offset to the size of a fixnum. */
 
 void osdep_lseekfile( word w_fd, word w_offset, word w_whence )
@@ -206,6 +206,11 @@ void osdep_chdir ( word w_cmd )
   globals[ G_RESULT ] = fixnum(-1);
 }
 
+void osdep_getpid( void )
+{
+  globals[ G_RESULT ] = fixnum(0);
+}
+
 word osdep_dlopen( const char *path )
 {
   OSErr r;
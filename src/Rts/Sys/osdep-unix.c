@@ -19,6 +19,7 @@
 #include <sys/stat.h>
 #include <sys/utsname.h>
 #include <sys/mman.h>		/* For mmap() and munmap() */
+#include <sys/uio.h>		/* For writev() */
 #include <limits.h>
 #include <unistd.h>
 #include <time.h>
@@ -34,6 +35,10 @@
 #ifdef HAVE_DLFCN
 # include <dlfcn.h>
 #endif
+#if defined(LINUX)
+# include <sys/sendfile.h>	/* For sendfile() */
+# include <sys/syscall.h>	/* For copy_file_range() and splice() */
+#endif
 
 #if defined(SUNOS4)		/* Not in any header file. */
 extern int gettimeofday( struct timeval *tp, struct timezone *tzp );
@@ -44,6 +49,7 @@ extern int poll( struct pollfd *fds, unsigned long nfds, int timeout );
 
 #include "larceny.h"
 #include "memmgr.h"		/* for GC_CHUNK_SIZE */
+#include "gclib.h"		/* for the page table */
 
 static stat_time_t real_start;
 
@@ -96,8 +102,9 @@ word w_fn, w_flags, w_mode;
   int mode = nativeint( w_mode );
   int newflags = 0;
 
-  if (flags & 0x01) newflags |= O_RDONLY;
-  if (flags & 0x02) newflags |= O_WRONLY;
+  if ((flags & 0x03) == 0x03) newflags |= O_RDWR;
+  else if (flags & 0x01) newflags |= O_RDONLY;
+  else if (flags & 0x02) newflags |= O_WRONLY;
   if (flags & 0x04) newflags |= O_APPEND;
   if (flags & 0x08) newflags |= O_CREAT;
   if (flags & 0x10) newflags |= O_TRUNC;
@@ -148,6 +155,190 @@ word w_fd, w_buf, w_cnt, w_offset;
 				     nativeint( w_cnt ) ) );
 }
 
+/* The chunk vector holds (bytevector, offset, count) triples; the
+   'n' triples starting at triple number 'start' go to the kernel in a
+   single writev().  Triples beyond OSDEP_IOV_MAX (or the system's
+   IOV_MAX) are left for the caller, which must loop on short writes
+   anyway.
+   */
+
+#define OSDEP_IOV_MAX  64
+
+void osdep_writevfile( w_fd, w_chunks, w_start, w_n )
+word w_fd, w_chunks, w_start, w_n;
+{
+  struct iovec iov[ OSDEP_IOV_MAX ];
+  int i, k, n = nativeint( w_n );
+
+  if (n > OSDEP_IOV_MAX) n = OSDEP_IOV_MAX;
+#if defined IOV_MAX
+  if (n > IOV_MAX) n = IOV_MAX;
+#endif
+  for ( i=0, k=3*nativeint( w_start ) ; i < n ; i++, k+=3 ) {
+    iov[i].iov_base = string_data( vector_ref( w_chunks, k ) )
+                      + nativeint( vector_ref( w_chunks, k+1 ) );
+    iov[i].iov_len = nativeint( vector_ref( w_chunks, k+2 ) );
+  }
+  globals[ G_RESULT ] = fixnum( writev( nativeint( w_fd ), iov, n ) );
+}
+
+/* Copies between descriptors without going through the Scheme heap.
+   On Linux the kernel does the copying: copy_file_range() handles
+   file-to-file copies, sendfile() handles copies from a file to
+   anything (sockets in particular), and splice() handles copies from
+   or to a pipe.  Each is tried in turn and the next one is tried if
+   it fails; if none applies, the bytes are moved through a C buffer
+   with read() and write().
+
+   The calls are made through syscall() so that the code does not
+   depend on the C library being recent enough to declare them.
+   */
+
+#define OSDEP_COPY_BUFSIZ  65536
+
+void osdep_copyfd( w_from, w_to, w_cnt )
+word w_from, w_to, w_cnt;
+{
+  static char *buf = 0;
+  int from = nativeint( w_from );
+  int to = nativeint( w_to );
+  size_t cnt = nativeint( w_cnt );
+  ssize_t r, w, k;
+
+#if defined(LINUX)
+# if defined(SYS_copy_file_range)
+  /* Zero is not trusted to mean end of file: copy_file_range() reports
+     zero bytes for pseudo-files such as those in /proc. */
+  r = syscall( SYS_copy_file_range, from, NULL, to, NULL, cnt, 0 );
+  if (r > 0) {
+    globals[ G_RESULT ] = fixnum( r );
+    return;
+  }
+# endif
+  r = sendfile( to, from, NULL, cnt );
+  if (r >= 0) {
+    globals[ G_RESULT ] = fixnum( r );
+    return;
+  }
+# if defined(SYS_splice)
+  r = syscall( SYS_splice, from, NULL, to, NULL, cnt, 0 );
+  if (r >= 0) {
+    globals[ G_RESULT ] = fixnum( r );
+    return;
+  }
+# endif
+#endif
+
+  if (buf == 0 && (buf = (char*)malloc( OSDEP_COPY_BUFSIZ )) == 0) {
+    globals[ G_RESULT ] = fixnum( -1 );
+    return;
+  }
+  r = read( from, buf, min( cnt, OSDEP_COPY_BUFSIZ ) );
+  for ( k=0 ; k < r ; k += w ) {
+    w = write( to, buf+k, r-k );
+    if (w <= 0) {
+      globals[ G_RESULT ] = fixnum( -1 );
+      return;
+    }
+  }
+  globals[ G_RESULT ] = fixnum( r );
+}
+
+/* A mapped file is a bytevector in a block that is mapped outside the
+   heap: the first page of the block is anonymous memory that holds the
+   large-object header, the bytevector header, and a prefix of less than
+   a page that is not part of the file; the file is mapped onto the rest
+   of the block.  The block is entered in the large-object space, which
+   never moves the object and unmaps the block when the object dies, and
+   bytevectors are never scanned, so the collector needs to know nothing
+   else.  Only the first page is counted as heap memory.
+
+   The index of the first byte of the file window is stored in the first
+   word of the prefix.
+   */
+
+#if !GCLIB_LARGE_TABLE && !defined(BDW_GC)
+/* The value of a nonnegative fixnum or bignum that fits in an off_t,
+   or -1.
+   */
+static off_t file_offset( word w )
+{
+  off_t offset = 0;
+  int i;
+
+  if (is_fixnum( w ))
+    return (s_word)w < 0 ? -1 : (off_t)nativeint( w );
+  if (tagof( w ) != BVEC_TAG || (*ptrof( w ) & 255) != BIGNUM_HDR ||
+      bignum_sign( w ) != 0 || bignum_length( w )*4 > sizeof(off_t))
+    return -1;
+  for ( i = bignum_length( w )-1 ; i >= 0 ; i-- )
+    offset = ((offset << 16) << 16) | bignum_ref32( w, i );
+  return offset < 0 ? -1 : offset;
+}
+#endif
+
+void osdep_mmapfile( w_fd, w_offset, w_length, w_shared )
+word w_fd, w_offset, w_length, w_shared;
+{
+#if GCLIB_LARGE_TABLE || defined(BDW_GC)
+  globals[ G_RESULT ] = FALSE_CONST;
+#else
+  int fd = nativeint( w_fd );
+  off_t offset = file_offset( w_offset );
+  off_t base = offset & ~(off_t)PAGEMASK;
+  int length = nativeint( w_length );
+  int skip = offset - base;
+  int prefix, maplen;
+  struct stat st;
+  word *p;
+  byte *block;
+
+  if (offset < 0 || fstat( fd, &st ) == -1 || getpagesize() > PAGESIZE) {
+    globals[ G_RESULT ] = FALSE_CONST;
+    return;
+  }
+  if (offset >= st.st_size)
+    length = 0;
+  else if (length > st.st_size - offset)
+    length = st.st_size - offset;
+  if (length > (LARGEST_OBJECT & ~7) - (int)sizeof(word) - PAGESIZE - skip)
+    length = (LARGEST_OBJECT & ~7) - (int)sizeof(word) - PAGESIZE - skip;
+  if (length <= 0) {
+    globals[ G_RESULT ] = FALSE_CONST;
+    return;
+  }
+
+  maplen = roundup_page( skip + length );
+  block = mmap( 0, PAGESIZE + maplen, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANON, -1, 0 );
+  if (block == MAP_FAILED) {
+    globals[ G_RESULT ] = FALSE_CONST;
+    return;
+  }
+  if ((word)block % PAGESIZE != 0 ||
+      mmap( block + PAGESIZE, maplen, PROT_READ | PROT_WRITE,
+            (w_shared != FALSE_CONST ? MAP_SHARED : MAP_PRIVATE) | MAP_FIXED,
+            fd, base ) == MAP_FAILED ||
+      (p = allocate_mapped_block( block, PAGESIZE + maplen )) == 0) {
+    munmap( block, PAGESIZE + maplen );
+    globals[ G_RESULT ] = FALSE_CONST;
+    return;
+  }
+
+  prefix = (block + PAGESIZE) - (byte*)(p+1);
+  *p = mkheader( prefix + skip + length, BV_HDR );
+  *(p+1) = prefix + skip;
+  globals[ G_RESULT ] = tagptr( p, BVEC_TAG );
+#endif
+}
+
+void osdep_unmapfile( void *addr, int bytes )
+{
+  if (munmap( addr, bytes ) == -1)
+    panic_abort( "munmap: %s: failed to unmap file at 0x%08x.",
+                 strerror( errno ), addr );
+}
+
 /* FIXME: limits offset to the size of a fixnum. */
 
 void osdep_lseekfile( w_fd, w_offset, w_whence )
@@ -273,6 +464,11 @@ void osdep_cwd( void )
   }
 }
 
+void osdep_getpid( void )
+{
+  globals[G_RESULT] = fixnum( getpid() );
+}
+
 /* returns a freshly allocated bytevector containing dp */
 
 void osdep_listdir_open( word w_path )
@@ -159,6 +159,11 @@ void osdep_cwd( void )
   }
 }
 
+void osdep_getpid( void )
+{
+  globals[G_RESULT] = fixnum( GetCurrentProcessId() & 0x1FFFFFFF );
+}
+
 #if 0
 /* FIXME: this should work with gcc and many other compilers, */
 /* but probably won't work with Microsoft compilers.          */
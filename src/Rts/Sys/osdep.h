@@ -178,6 +178,57 @@ extern void osdep_writefile( word fd, word buf, word nbytes, word offset );
      FIXME: there is no way to distinguish between errors.
      */
 
+extern void osdep_writevfile( word fd, word chunks, word start, word n );
+  /* 'chunks' is a vector of (buf, offset, count) triples, where each 'buf'
+     is a bytevector-like structure and 'offset' and 'count' are fixnums
+     that lie within it; 'start' and 'n' are fixnums that select 'n'
+     triples beginning with triple number 'start'.  Write the described
+     byte ranges, in order, to the file described by 'fd',
+     using a single vectored write where the platform has one.  The call
+     may write fewer bytes than requested, under the same blocking rules
+     as osdep_writefile().
+     Place the total number of bytes written as a fixnum in
+     globals[G_RESULT], or -1 on error.
+
+     FIXME: this function should take globals[] as a parameter.
+     FIXME: there is no way to distinguish between errors.
+     */
+
+extern void osdep_copyfd( word from, word to, word nbytes );
+  /* Copy at most 'nbytes' bytes from the descriptor 'from' to the
+     descriptor 'to' without passing them through the Scheme heap,
+     using whatever in-kernel copying the operating system offers.
+     'nbytes' is a fixnum; 'from' and 'to' are opaque.  The call may
+     block the process under the same rules as osdep_readfile() and
+     osdep_writefile(), and may copy fewer than 'nbytes' bytes.
+     Place the number of bytes copied as a fixnum in globals[G_RESULT],
+     0 on end-of-file, or -1 on error.
+
+     FIXME: this function should take globals[] as a parameter.
+     FIXME: there is no way to distinguish between errors.
+     */
+
+extern void osdep_mmapfile( word fd, word offset, word length, word shared );
+  /* Map at most 'length' bytes of the file described by 'fd', starting
+     at byte 'offset', into a fresh bytevector whose pages are mapped
+     outside the Scheme heap and are not charged to it.  'offset' is a
+     nonnegative fixnum or bignum and 'length' is a fixnum; if 'shared'
+     is not #f then stores into the bytevector are written to the file,
+     otherwise they are private to the process.
+     The file window starts at a byte index of the bytevector that is
+     recorded, as a native 32-bit integer, in its first four bytes.
+     The mapping is removed when the bytevector is garbage collected.
+     Place the bytevector in globals[G_RESULT], or #f if the file could
+     not be mapped or the platform cannot map files.
+
+     FIXME: this function should take globals[] as a parameter.
+     */
+
+extern void osdep_unmapfile( void *addr, int bytes );
+  /* Unmap the block [addr, addr+bytes) established by osdep_mmapfile().
+     Called by the low-level allocator when a mapped bytevector dies.
+     */
+
 extern void osdep_lseekfile( word fd, word offset, word whence );
   /* Set the file offset for fd as specified by offset and whence:
      If whence is 0, set the file offset to offset bytes.
@@ -254,6 +305,12 @@ extern void osdep_cwd( void );
      Returns #f on error or if unimplemented, otherwise the string.
      */
 
+extern void osdep_getpid( void );
+  /* Get the process identifier as a fixnum.
+
+     Returns fixnum(0) if the platform has no process identifiers.
+     */
+
 extern void osdep_listdir_open( word w_path );
   /* Opens the directory and returns its state in a new bytevector.
 
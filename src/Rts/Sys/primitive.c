@@ -208,6 +208,16 @@ void primitive_allocate_nonmoving( word w_length, word w_tag )
     allocate_nonmoving( nativeint( w_length ), nativeint( w_tag ) );
 }
 
+void primitive_make_pinned_bytevector( word w_length )
+{
+  globals[ G_RESULT ] = allocate_pinned_bytevector( nativeint( w_length ) );
+}
+
+void primitive_pinnedp( word w_obj )
+{
+  globals[ G_RESULT ] = is_pinned_object( w_obj ) ? TRUE_CONST : FALSE_CONST;
+}
+
 void primitive_object_to_address( word w_obj )
 {
   /* Invariant: the pointer _must_ point to nonrelocatable memory,
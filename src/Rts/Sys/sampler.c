@@ -0,0 +1,191 @@
+/* Copyright 2026 The Larceny Project.
+ *
+ * $Id$
+ *
+ * Larceny run-time system -- statistical (sampling) profiler.
+ *
+ * While the profiler runs, an interval timer sends SIGPROF every so
+ * many microseconds of cpu time.  The handler (Sys/signals.c) only
+ * counts the tick.  The sample is taken at the next expiry of the
+ * software timer, when millicode calls sampler_poll(): at that point
+ * the virtual machine state is in globals[] and the stack is
+ * consistent, so the current procedure (REG0) and the procedures saved
+ * in the innermost continuation frames can be read safely, with
+ * stk_sample_procedures() in Sys/stack.c.  The software timer expires
+ * every TIMER_STEP ticks, so the delay is short.  Ticks that arrive
+ * during garbage collection or a syscall are charged to the first
+ * sample taken after it.
+ *
+ * Samples go into a ring of fixed-size records that is allocated when
+ * the profiler is started, so taking a sample allocates nothing:
+ *
+ *   0:   number of ticks the record accounts for (fixnum)
+ *   1:   number of procedures that follow (fixnum)
+ *   2..: procedures, innermost first
+ *
+ * When the ring is full the oldest record is overwritten.  The ring
+ * holds pointers into the heap, so the collector treats the records in
+ * use as roots (sampler_enumerate_roots(), called from memmgr.c).
+ *
+ * The Scheme side is lib/Experimental/sampling-profiler.sch.
+ */
+
+#include <stdlib.h>
+
+#include "larceny.h"
+#include "signals.h"
+#include "stack.h"
+
+/* Operations; must agree with lib/Experimental/sampling-profiler.sch. */
+
+#define SAMPLER_START  0
+#define SAMPLER_STOP   1
+#define SAMPLER_COUNT  2
+#define SAMPLER_REF    3
+#define SAMPLER_CLEAR  4
+#define SAMPLER_LOST   5
+
+static struct {
+  word *ring;                   /* nrecords records of (2+depth) words */
+  int  depth;                   /* max procedures per record */
+  int  nrecords;
+  int  next;                    /* record to be written next */
+  int  count;                   /* records in use */
+  int  lost;                    /* records overwritten */
+  int  running;
+} sampler;
+
+#define RECORD( i )  (sampler.ring + (i)*(sampler.depth+2))
+
+void sampler_poll( word *globals )
+{
+  word *r;
+  int ticks, n;
+
+  if (!sampler.running || profile_ticks == 0)
+    return;
+
+  ticks = profile_ticks;
+  profile_ticks = 0;            /* A tick that arrives in between is lost */
+
+  r = RECORD( sampler.next );
+  n = 0;
+  if (tagof( globals[ G_REG0 ] ) == PROC_TAG)
+    r[2+n++] = globals[ G_REG0 ];
+  n += stk_sample_procedures( globals, r+2+n, sampler.depth-n );
+  r[0] = fixnum( ticks );
+  r[1] = fixnum( n );
+
+  sampler.next = (sampler.next + 1) % sampler.nrecords;
+  if (sampler.count < sampler.nrecords)
+    sampler.count++;
+  else
+    sampler.lost++;
+}
+
+/* While the ring is filling, the records in use are 0..count-1; once
+   it is full, all of them are. */
+
+void sampler_enumerate_roots( void (*f)( word*, void* ), void *data )
+{
+  word *r;
+  int i, j;
+
+  for ( i=0 ; i < sampler.count ; i++ ) {
+    r = RECORD( i );
+    for ( j=0 ; j < nativeint( r[1] ) ; j++ )
+      f( &r[2+j], data );
+  }
+}
+
+static word sampler_start( word w_usec, word w_depth, word w_nrecords )
+{
+  int usec, depth, nrecords;
+
+  if (sampler.running
+      || !is_fixnum( w_usec ) || !is_fixnum( w_depth )
+      || !is_fixnum( w_nrecords ))
+    return FALSE_CONST;
+  usec = nativeint( w_usec );
+  depth = nativeint( w_depth );
+  nrecords = nativeint( w_nrecords );
+  if (usec <= 0 || depth <= 0 || nrecords <= 0)
+    return FALSE_CONST;
+
+  if (sampler.ring != 0)
+    free( sampler.ring );
+  sampler.ring = 0;
+  sampler.count = sampler.next = sampler.lost = 0;
+  sampler.ring = (word*)malloc( (size_t)nrecords*(depth+2)*sizeof( word ) );
+  if (sampler.ring == 0)
+    return FALSE_CONST;
+  sampler.depth = depth;
+  sampler.nrecords = nrecords;
+
+  profile_ticks = 0;
+  sampler.running = 1;
+  if (!start_profile_timer( usec )) {
+    sampler.running = 0;
+    return FALSE_CONST;
+  }
+  return TRUE_CONST;
+}
+
+/* Reads word j of the i'th oldest record. */
+
+static word sampler_ref( word w_i, word w_j )
+{
+  word *r;
+  int i, j;
+
+  if (!is_fixnum( w_i ) || !is_fixnum( w_j ))
+    return FALSE_CONST;
+  i = nativeint( w_i );
+  j = nativeint( w_j );
+  if (i < 0 || i >= sampler.count || j < 0)
+    return FALSE_CONST;
+
+  r = RECORD( (sampler.next - sampler.count + i + sampler.nrecords)
+              % sampler.nrecords );
+  if (j >= 2 + nativeint( r[1] ))
+    return FALSE_CONST;
+  return r[j];
+}
+
+void primitive_sampler( word w_op, word w_a, word w_b, word w_c )
+{
+  word result = FALSE_CONST;
+
+  switch (nativeint( w_op )) {
+  case SAMPLER_START :
+    result = sampler_start( w_a, w_b, w_c );
+    break;
+  case SAMPLER_STOP :
+    if (sampler.running) {
+      stop_profile_timer();
+      sampler.running = 0;
+    }
+    result = TRUE_CONST;
+    break;
+  case SAMPLER_COUNT :
+    result = fixnum( sampler.count );
+    break;
+  case SAMPLER_REF :
+    result = sampler_ref( w_a, w_b );
+    break;
+  case SAMPLER_CLEAR :
+    sampler.count = sampler.next = sampler.lost = 0;
+    if (!sampler.running && sampler.ring != 0) {
+      free( sampler.ring );
+      sampler.ring = 0;
+    }
+    result = TRUE_CONST;
+    break;
+  case SAMPLER_LOST :
+    result = fixnum( sampler.lost );
+    break;
+  }
+  globals[ G_RESULT ] = result;
+}
+
+/* eof */
@@ -98,6 +98,17 @@ int sigsetmask( int );		/* Should be in <signal.h> but isn't */
 static int __stdcall win32_inthandler(unsigned long sig);
 #endif
 
+#if defined(XOPEN_SIGNALS) || defined(POSIX_SIGNALS)
+# include <sys/time.h>
+#endif
+
+#if defined(XOPEN_SIGNALS)
+  static void profhandler( int, siginfo_t *, void * );
+#elif defined(POSIX_SIGNALS)
+  static void profhandler( int );
+#endif
+
+volatile sig_atomic_t profile_ticks = 0;
 signal_set_t syscall_blocked_signals;
 jmp_buf      syscall_interrupt_buf;
 int          in_interruptible_syscall = 0;
@@ -269,6 +280,64 @@ static void fpehandler( int sig )
   }
 }
 
+/* Profiling signal: counts the tick for the sampling profiler, which
+   takes the sample at the next timer expiry (see Sys/sampler.c).
+   The handler does not touch the virtual machine, so it is safe in
+   any of the three modes.
+   */
+#if defined(XOPEN_SIGNALS)
+static void profhandler( int sig, siginfo_t *siginfo, void *context )
+{
+  profile_ticks++;
+}
+#elif defined(POSIX_SIGNALS)
+static void profhandler( int sig )
+{
+  profile_ticks++;
+}
+#endif
+
+/* Starts delivering SIGPROF every usec microseconds of cpu time.
+   Returns 1 on success and 0 if interval timers are not available.
+   */
+int start_profile_timer( int usec )
+{
+#if defined(XOPEN_SIGNALS) || defined(POSIX_SIGNALS)
+  struct sigaction act;
+  struct itimerval it;
+
+  act.sa_flags = SA_RESTART | SA_ONSTACK;
+  sigfillset( &act.sa_mask );
+# if defined(XOPEN_SIGNALS)
+  act.sa_flags |= SA_SIGINFO;
+  act.sa_sigaction = profhandler;
+# else
+  act.sa_handler = profhandler;
+# endif
+  if (sigaction( SIGPROF, &act, (struct sigaction*)0 ) < 0)
+    return 0;
+
+  it.it_interval.tv_sec = usec / 1000000;
+  it.it_interval.tv_usec = usec % 1000000;
+  it.it_value = it.it_interval;
+  return setitimer( ITIMER_PROF, &it, (struct itimerval*)0 ) == 0;
+#else
+  return 0;
+#endif
+}
+
+void stop_profile_timer( void )
+{
+#if defined(XOPEN_SIGNALS) || defined(POSIX_SIGNALS)
+  struct itimerval it;
+
+  it.it_interval.tv_sec = it.it_interval.tv_usec = 0;
+  it.it_value = it.it_interval;
+  setitimer( ITIMER_PROF, &it, (struct itimerval*)0 );
+  signal( SIGPROF, SIG_IGN );
+#endif
+}
+
 void block_all_signals( signal_set_t *s )  /* s may be NULL */
 {
 #if defined(BSD_SIGNALS)
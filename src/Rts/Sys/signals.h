@@ -97,6 +97,9 @@ extern jmp_buf      syscall_interrupt_buf;
 extern int          in_interruptible_syscall;
 extern int          in_noninterruptible_syscall;
 extern signal_set_t syscall_blocked_signals;
+extern volatile sig_atomic_t profile_ticks;
+extern int          start_profile_timer( int usec );
+extern void         stop_profile_timer( void );
 
 /* In $MACHINE/signals.c */
 extern void execute_sigfpe_magic( void *context ); /* misnamed */
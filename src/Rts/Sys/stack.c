@@ -86,10 +86,20 @@ static struct {
   int stacks_created;
   int frames_flushed;
   int words_flushed;
+  int frames_prefetched;
 } stack_state;                        /* FIXME: hang off GC or globals */
 
 #define STACK_BASE_SIZE    16   /* bytes */
 
+/* Underflow restores the top heap frame and, if it is small and there
+ * is plenty of room, the one below it, halving the trips through the
+ * underflow handler when returning through a continuation.  A frame
+ * that is restored but not returned through is copied to the heap again
+ * by the next capture, so at most one such frame is prefetched.
+ */
+#define RESTORE_MAX_FRAMES  2
+#define RESTORE_MAX_BYTES   512
+
 /* Allocates and initializes a stack underflow frame. */
 
 int stk_create( word *globals )
@@ -190,65 +200,134 @@ void stk_flush( word *globals )
   stack_state.frames_flushed += framecount;
 }
 
+/* Converts the header and return offset of a frame just copied from
+ * the heap back to their stack form.
+ */
+static void convert_restored_frame( word *stktop )
+{
+  word retoffs, proc, codeaddr, codeptr, header;
+
+  header  = *(stktop+HC_HEADER);
+  retoffs = *(stktop+HC_RETOFFSET);
+  proc    = *(stktop+HC_PROC);
+
+  /* convert the header back to a fixnum */
+  *(stktop+STK_CONTSIZE) = sizefield(header);
+
+  /* convert the return address */
+  if (proc != 0) {
+    codeptr = *(ptrof( proc )+PROC_CODEPTR);
+    if (tagof( codeptr ) == BVEC_TAG) {
+      codeaddr = (word)ptrof( codeptr );
+      *(stktop+STK_RETADDR) = (codeaddr+4)+retoffs;
+    } else {
+      *(stktop+STK_RETADDR) = retoffs;
+    }
+  } else {
+    *(stktop+STK_RETADDR) = retoffs;
+  }
+}
+
 /* NOTE:  A copy of this code exists in Sparc/memory.s; if you change 
- * anything here, check that code as well.
+ * anything here, check that code as well.  (That copy restores one
+ * frame at a time.)
  */
 int stk_restore_frame( word *globals )
 {
-  word *stktop, *hframe, *p;
-  word retoffs, proc, codeaddr, codeptr, header;
-  unsigned size;
+  word *stktop, *hframe, *p, *limit;
+  word *hframes[ RESTORE_MAX_FRAMES ];
+  unsigned sizes[ RESTORE_MAX_FRAMES ];
+  unsigned size, total;
+  word k;
+  int n, i;
 
   assert2(globals[ G_STKP ] == globals[ G_STKBOT ]);
 
-  hframe = ptrof( globals[ G_CONT ] );
-  size = roundup8( sizefield( *hframe ) + 4 );   /* bytes to copy */
-  stktop = (word*)globals[ G_STKP ];
+  /* The top frame must be restored; the one below it is optional and
+     is taken only if it leaves room for a maximal frame. */
+  hframes[0] = ptrof( globals[ G_CONT ] );
+  sizes[0] = total = roundup8( sizefield( *hframes[0] ) + 4 );
+  limit = (word*)globals[ G_ETOP ] + SCE_BUFFER + MAX_STACK_FRAME/4;
+  k = *(hframes[0]+HC_DYNLINK);
+  n = 1;
+  while (n < RESTORE_MAX_FRAMES && tagof( k ) == VEC_TAG) {
+    size = roundup8( sizefield( *ptrof( k ) ) + 4 );
+    if (total + size > RESTORE_MAX_BYTES
+        || (word*)globals[ G_STKP ] - (total + size) / 4 < limit)
+      break;
+    hframes[n] = ptrof( k );
+    sizes[n] = size;
+    total += size;
+    n++;
+    k = *(ptrof( k )+HC_DYNLINK);
+  }
 
-  stktop -= size / 4;
+  stktop = (word*)globals[ G_STKP ];
+  stktop -= total / 4;
   if (stktop < (word*)globals[ G_ETOP ]) {
     supremely_annoyingmsg( "Failed to create stack." );
     return 0;
   }
   globals[ G_STKP ] = (word)stktop;
   globals[ G_STKUFLOW ] += 1;
+  stack_state.frames_prefetched += n-1;
 
 #if 0
-  annoyingmsg("Restore: %d", size);
+  annoyingmsg("Restore: %d frames, %d bytes", n, total);
 #endif
 
-  /* copy the frame onto the stack */
+  /* copy the frames onto the stack, the top frame lowest */
   p = stktop;
-  while (size) {
-    *p++ = *hframe++;
-    *p++ = *hframe++;
-    size -= 8;
+  for ( i=0 ; i < n ; i++ ) {
+    hframe = hframes[i];
+    size = sizes[i];
+    while (size) {
+      *p++ = *hframe++;
+      *p++ = *hframe++;
+      size -= 8;
+    }
+    convert_restored_frame( p - sizes[i]/4 );
   }
 
   /* Follow continuation chain. */
-  globals[ G_CONT ] = *(stktop+STK_DYNLINK);
+  globals[ G_CONT ] = *(p - sizes[n-1]/4 + STK_DYNLINK);
 
-  header  = *(stktop+HC_HEADER);
-  retoffs = *(stktop+HC_RETOFFSET);
-  proc    = *(stktop+HC_PROC);
+  return 1;
+}
 
-  /* convert the header back to a fixnum */
-  *(stktop+STK_CONTSIZE) = sizefield(header);
+/* Walks the frames the way stk_flush() does, but without converting
+ * them, then follows the dynamic links of the heap frames.  Frames whose
+ * saved REG0 is not a procedure (see the special case above) are skipped.
+ * Called by the sampling profiler (Sys/sampler.c) at a timer interrupt.
+ */
+int stk_sample_procedures( word *globals, word *buf, int max )
+{
+  word *stktop, *stkbot, *hframe;
+  word proc, size, k;
+  int n;
 
-  /* convert the return address */
-  if (proc != 0) {
-    codeptr = *(ptrof( proc )+PROC_CODEPTR);
-    if (tagof( codeptr ) == BVEC_TAG) {
-      codeaddr = (word)ptrof( codeptr );
-      *(stktop+STK_RETADDR) = (codeaddr+4)+retoffs;
-    } else {
-      *(stktop+STK_RETADDR) = retoffs;
-    }
-  } else {
-    *(stktop+STK_RETADDR) = retoffs;
+  stktop = (word*)globals[ G_STKP ];
+  stkbot = (word*)globals[ G_STKBOT ];
+
+  n = 0;
+  while (stktop < stkbot && n < max) {
+    size = *(stktop+STK_CONTSIZE);
+    proc = *(stktop+STK_REG0);
+    if (tagof( proc ) == PROC_TAG)
+      buf[n++] = proc;
+    size = roundup8( size+4 );
+    stktop += size / 4;
   }
 
-  return 1;
+  k = globals[ G_CONT ];
+  while (tagof( k ) == VEC_TAG && n < max) {
+    hframe = ptrof( k );
+    proc = *(hframe+HC_PROC);
+    if (tagof( proc ) == PROC_TAG)
+      buf[n++] = proc;
+    k = *(hframe+HC_DYNLINK);
+  }
+  return n;
 }
 
 int stk_size_for_top_stack_frame( word *globals )
@@ -272,11 +351,14 @@ void stk_stats( word *globals, stack_stats_t *stats )
   stats->stacks_created = stack_state.stacks_created;
   stats->frames_flushed = stack_state.frames_flushed;
   stats->words_flushed = stack_state.words_flushed;
-  stats->frames_restored = globals[ G_STKUFLOW ];
+  stats->frames_restored = globals[ G_STKUFLOW ]
+                           + stack_state.frames_prefetched;
+  stats->frames_prefetched = stack_state.frames_prefetched;
 
   stack_state.stacks_created = 0;
   stack_state.frames_flushed = 0;
   stack_state.words_flushed = 0;
+  stack_state.frames_prefetched = 0;
   globals[ G_STKUFLOW ] = 0;
 }
 
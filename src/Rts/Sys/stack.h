@@ -41,6 +41,13 @@ int stk_size_for_top_stack_frame( word *globals );
      as the top stack frame in the current stack.
      */
 
+int stk_sample_procedures( word *globals, word *buf, int max );
+  /* Store in buf the procedures saved in the innermost max frames of
+     the continuation, innermost first, and return their number.  Reads
+     the stack cache and then the heap frames; changes nothing and
+     allocates nothing.
+     */
+
 void stk_stats( word *globals, stack_stats_t *stats );
   /* Fill in the stats structure with statistics about the stack module.
      */
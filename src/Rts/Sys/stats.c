@@ -175,6 +175,8 @@ struct gclib_memstat {
   word smircy_allocated;	/* words allocated to marking state */
   word smircy_allocated_max;	/* max of smircy_allocated over time */
   word smircy_allocated_peak;	/* smircy_allocated at mem peak */
+  word pinned_allocated;	/* heap words holding pinned objects */
+  word pinned_allocated_max;	/* max of pinned_allocated over time */
   word rts_allocated;		/* words allocated to RTS "other" */
   word rts_allocated_max;	/* max words allocated to rts */
   word rts_allocated_peak;	/* words allocated to rts at mem peak */
@@ -380,6 +382,7 @@ struct stack_memstat {
   DWORD( words_flushed );	/* words of stack frames flushed or copied */
   DWORD( frames_flushed );	/* number of stack frames flushed */
   DWORD( frames_restored );	/* number of stack frames restored */
+  DWORD( frames_prefetched );	/* ... below the top frame, on underflow */
 };
 
 struct gen_memstat {
@@ -647,6 +650,8 @@ void stats_add_gclib_stats( gclib_stats_t *stats )
   PUT_WORD2( stats, s, summ_allocated_max );
   PUT_WORD2( stats, s, smircy_allocated );
   PUT_WORD2( stats, s, smircy_allocated_max );
+  PUT_WORD2( stats, s, pinned_allocated );
+  PUT_WORD2( stats, s, pinned_allocated_max );
   PUT_WORD2( stats, s, rts_allocated );
   PUT_WORD2( stats, s, rts_allocated_max );
   PUT_WORD2( stats, s, heap_fragmentation );
@@ -798,6 +803,7 @@ void stats_add_stack_stats( stack_stats_t *stats )
   ADD_DWORD( stats, s, words_flushed );
   ADD_DWORD( stats, s, frames_flushed );
   ADD_DWORD( stats, s, frames_restored );
+  ADD_DWORD( stats, s, frames_prefetched );
 }
 
 void stats_add_gen_stats( stats_id_t generation, gen_stats_t *stats )
@@ -975,6 +981,8 @@ static void fill_main_entries( word *vp )
   vp[ STAT_SUMMSETS_MAX ]  = gclib->summ_allocated_max;
   vp[ STAT_WORDS_SMIRCY ]  = gclib->smircy_allocated;
   vp[ STAT_SMIRCY_MAX ]    = gclib->smircy_allocated_max;
+  vp[ STAT_WORDS_PINNED ]  = gclib->pinned_allocated;
+  vp[ STAT_PINNED_MAX ]    = gclib->pinned_allocated_max;
   vp[ STAT_WORDS_RTS ]     = gclib->rts_allocated;
   vp[ STAT_RTS_MAX ]       = gclib->rts_allocated_max;
   vp[ STAT_WORDS_WASTAGE ] = gclib->heap_fragmentation;
@@ -1205,6 +1213,8 @@ static void fill_main_entries( word *vp )
   vp[ STAT_WFLUSHED_LO ]   = stack->words_flushed_lo;
   vp[ STAT_FRESTORED_HI ]  = stack->frames_restored_hi;
   vp[ STAT_FRESTORED_LO ]  = stack->frames_restored_lo;
+  vp[ STAT_FPREFETCHED_HI ] = stack->frames_prefetched_hi;
+  vp[ STAT_FPREFETCHED_LO ] = stack->frames_prefetched_lo;
 
   /* simulated barrier */
 #if defined(SIMULATE_NEW_BARRIER)
@@ -1437,6 +1447,8 @@ static void stats_dump_state_now( FILE *f )
     PRINT_FIELD( f, s, smircy_allocated );
     PRINT_FIELD( f, s, smircy_allocated_max );
     PRINT_FIELD( f, s, smircy_allocated_peak );
+    PRINT_FIELD( f, s, pinned_allocated );
+    PRINT_FIELD( f, s, pinned_allocated_max );
     PRINT_FIELD( f, s, rts_allocated );
     PRINT_FIELD( f, s, rts_allocated_max );
     PRINT_FIELD( f, s, rts_allocated_peak );
@@ -1473,6 +1485,7 @@ static void stats_dump_state_now( FILE *f )
     PRINT_DFIELD( f, s, words_flushed );
     PRINT_DFIELD( f, s, frames_flushed );
     PRINT_DFIELD( f, s, frames_restored );
+    PRINT_DFIELD( f, s, frames_prefetched );
     fprintf( f, ") " );
   }
 
@@ -22,6 +22,8 @@ struct gclib_stats {
   int summ_allocated_max;	/* max of summ_allocated over time */
   int smircy_allocated;		/* words allocated to marking state */
   int smircy_allocated_max;	/* max of smircy_allocated over time */
+  int pinned_allocated;		/* heap words holding pinned objects */
+  int pinned_allocated_max;	/* max of pinned_allocated over time */
   int rts_allocated;		/* words allocated to run-time systems */
   int rts_allocated_max;	/* max of rts_allocated over time */
   int heap_fragmentation;	/* words of fragmentation in heap areas */
@@ -148,6 +150,7 @@ struct stack_stats {
   int frames_flushed;		/* stack frames flushed */
   int words_flushed;		/* bytes of stack flushed/copied */
   int frames_restored;		/* Stack frames restored */
+  int frames_prefetched;	/* ... of which not the top frame */
 };
 
 #if defined(SIMULATE_NEW_BARRIER)
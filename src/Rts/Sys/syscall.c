@@ -72,6 +72,25 @@ static struct {
 		      { (fptr)osdep_listdir_open, 1, 0 },
 		      { (fptr)osdep_listdir, 1, 0 },
 		      { (fptr)osdep_listdir_close, 1, 0 },
+		      { (fptr)osdep_writevfile, 4, 1 },
+		      { (fptr)osdep_copyfd, 3, 1 },
+		      { (fptr)osdep_mmapfile, 4, 0 },
+		      { (fptr)primitive_make_pinned_bytevector, 1, 0 },
+		      { (fptr)primitive_pinnedp, 1, 0 },
+		      { (fptr)larceny_C_ffi_init_stub, 4, 0 },
+		      { (fptr)larceny_C_ffi_call_stub, 2, 1 },
+		      { (fptr)primitive_hvector_op, 4, 0 },
+		      { (fptr)primitive_bytevector_scan, 4, 0 },
+		      { (fptr)primitive_utf8_decode, 4, 0 },
+		      { (fptr)primitive_utf8_encode, 4, 0 },
+		      { (fptr)primitive_string_ci_compare, 2, 0 },
+		      { (fptr)primitive_bytevector_digest, 4, 0 },
+		      { (fptr)osdep_getpid, 0, 0 },
+		      { (fptr)primitive_sampler, 4, 0 },
+		      { (fptr)primitive_bignum_op, 4, 0 },
+		      { (fptr)primitive_flonum_op, 4, 0 },
+		      { (fptr)primitive_oblist_lookup, 4, 0 },
+		      { (fptr)primitive_string_builder_append, 4, 0 },
 		    };
 
 void larceny_syscall( int nargs, int nproc, word *args )
@@ -104,4 +104,8 @@ void CDECL void_return( void *p )
   *(unsigned char*)p = 1;
 }
 
+/* Call overhead benchmark (ffi-bench.sch) */
+
+int CDECL return_zero( void ) { return 0; }
+
 /* eof */